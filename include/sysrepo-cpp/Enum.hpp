@@ -209,8 +209,19 @@ constexpr GetOptions operator|(const GetOptions a, const GetOptions b)
     return implEnumBitOr(a, b);
 }
 
+/**
+ * @brief Kind of a user callback registered through a Subscription.
+ */
+enum class CallbackType : uint32_t {
+    ModuleChange,
+    OperGet,
+    RPCAction,
+    Notification,
+};
+
 std::ostream& operator<<(std::ostream& os, const NotificationType& type);
 std::ostream& operator<<(std::ostream& os, const Event& event);
 std::ostream& operator<<(std::ostream& os, const ChangeOperation& changeOp);
 std::ostream& operator<<(std::ostream& os, const ErrorCode& err);
+std::ostream& operator<<(std::ostream& os, const CallbackType& type);
 }
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <sysrepo-cpp/Session.hpp>
+
+namespace sysrepo {
+/**
+ * @brief For internal use only.
+ *
+ * Holds the current snapshot of a MaterializedView. Replacing the snapshot is a single pointer swap, so readers never
+ * wait for a view to be built. The swap itself is guarded either by `std::atomic<std::shared_ptr>` (which is not
+ * lock-free in the common standard libraries), or by a mutex.
+ */
+template <typename T>
+class SnapshotHolder {
+public:
+    std::shared_ptr<const T> load() const
+    {
+#if __cpp_lib_atomic_shared_ptr
+        return m_current.load(std::memory_order_acquire);
+#else
+        std::lock_guard lock{m_mtx};
+        return m_current;
+#endif
+    }
+
+    void store(std::shared_ptr<const T> snapshot)
+    {
+#if __cpp_lib_atomic_shared_ptr
+        m_current.store(std::move(snapshot), std::memory_order_release);
+#else
+        std::lock_guard lock{m_mtx};
+        m_current.swap(snapshot);
+#endif
+    }
+
+private:
+#if __cpp_lib_atomic_shared_ptr
+    std::atomic<std::shared_ptr<const T>> m_current;
+#else
+    mutable std::mutex m_mtx;
+    std::shared_ptr<const T> m_current;
+#endif
+};
+
+/**
+ * @brief A user-defined projection of a module's data (e.g., interfaces indexed by their VLAN ID), kept up to date.
+ *
+ * The view is built once from the complete data of the module (via `build`), and then updated from the changes of each
+ * transaction (via `apply`) in the Done event. Each update produces a new immutable snapshot; readers get the current
+ * one via MaterializedView::snapshot and can keep using it for as long as they like, without blocking the updates.
+ *
+ * The update works on a copy of the previous snapshot, so `View` has to be copyable. If `apply` throws, the view is
+ * rebuilt from the current data via `build` instead, and the exception is passed to the exception handler. If `build`
+ * throws as well, the view has no snapshot until the next change rebuilds it.
+ */
+template <typename View>
+class MaterializedView {
+public:
+    /**
+     * Builds the view from scratch.
+     * @param data All data of the module (or the data selected by the XPath), std::nullopt if there are none.
+     */
+    using BuildFn = std::function<View(const std::optional<libyang::DataNode>& data)>;
+    /**
+     * Updates the view with changes of a single transaction.
+     */
+    using ApplyFn = std::function<void(View& view, const ChangeCollection& changes)>;
+
+    /**
+     * @param session The session to use for subscribing.
+     * @param moduleName The module which the view is built from.
+     * @param build Builds the view from scratch.
+     * @param apply Updates the view.
+     * @param xpath Optional XPath which limits both the data passed to `build` and the changes passed to `apply`.
+     * @param handler Optional exception handler for exceptions thrown by `build` and `apply`.
+     */
+    MaterializedView(Session session, const std::string& moduleName, BuildFn build, ApplyFn apply, const std::optional<std::string>& xpath = std::nullopt, ExceptionHandler handler = nullptr)
+        : m_current(std::make_shared<SnapshotHolder<View>>())
+        , m_sub(session.onModuleChange(
+                      moduleName,
+                      [current = m_current, build, apply, dataPath = xpath.value_or("/" + moduleName + ":*")] (Session session, auto, auto, auto, Event event, auto) {
+                          auto snapshot = current->load();
+                          if (event == Event::Enabled || !snapshot) {
+                              // During the Enabled event, sysrepo does not let any other change in, so this is consistent
+                              current->store(std::make_shared<const View>(build(session.getData(dataPath))));
+                          } else if (event == Event::Done) {
+                              auto updated = std::make_shared<View>(*snapshot);
+                              try {
+                                  // The parentheses keep a union (`/a | /b`) together
+                                  apply(*updated, session.getChanges("(" + dataPath + ")//."));
+                              } catch (...) {
+                                  // The previous snapshot is missing this change, and no later change would bring it back
+                                  current->store(nullptr);
+                                  current->store(std::make_shared<const View>(build(session.getData(dataPath))));
+                                  throw;
+                              }
+                              current->store(std::move(updated));
+                          }
+                          return ErrorCode::Ok;
+                      },
+                      xpath,
+                      0,
+                      SubscribeOptions::Enabled | SubscribeOptions::DoneOnly,
+                      handler))
+    {
+    }
+
+    /**
+     * Returns the current snapshot of the view. Never waits for a view to be built, and never returns nullptr once the
+     * constructor has finished (unless `build` has thrown).
+     */
+    std::shared_ptr<const View> snapshot() const
+    {
+        return m_current->load();
+    }
+
+private:
+    std::shared_ptr<SnapshotHolder<View>> m_current;
+    Subscription m_sub;
+};
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <sysrepo-cpp/Session.hpp>
+
+namespace sysrepo {
+/**
+ * @brief A notification read back from a NotificationStore.
+ */
+struct StoredNotification {
+    NotificationTimeStamp timestamp;
+    /**
+     * The whole tree of the notification, starting at the top-level node.
+     */
+    libyang::DataNode tree;
+};
+
+/**
+ * @brief A local, persistent log of received notifications, indexed by their timestamps.
+ *
+ * The notifications are appended to a single memory-mapped file, which grows as needed. An index of their timestamps
+ * is kept in memory (and rebuilt by scanning the file when it is opened), so that looking up the notifications from a
+ * time range does not read the rest of the file.
+ *
+ * NotificationStore::subscribe fills the store from a notification subscription. After a restart, it asks sysrepo to
+ * replay only the notifications since the last one in the store, rather than the whole history.
+ *
+ * All methods are safe to call from multiple threads. Only a single NotificationStore may use a file at a time; the file
+ * is locked via `flock`, and opening a file which is in use (by this or another process) throws.
+ */
+class NotificationStore {
+public:
+    NotificationStore(Session session, const std::filesystem::path& file);
+
+    void append(const libyang::DataNode& notification, const NotificationTimeStamp timestamp);
+    std::vector<StoredNotification> query(
+            const std::optional<NotificationTimeStamp>& from = std::nullopt,
+            const std::optional<NotificationTimeStamp>& to = std::nullopt,
+            const std::optional<std::string>& xpath = std::nullopt) const;
+    std::optional<NotificationTimeStamp> lastTimestamp() const;
+    size_t size() const;
+    void flush();
+
+    [[nodiscard]] Subscription subscribe(
+            Session session,
+            const std::string& moduleName,
+            const std::optional<std::string>& xpath = std::nullopt,
+            const SubscribeOptions opts = SubscribeOptions::Default);
+
+private:
+    struct State;
+    std::shared_ptr<State> m_state;
+};
+}
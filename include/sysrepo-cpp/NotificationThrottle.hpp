@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <sysrepo-cpp/Session.hpp>
+
+namespace sysrepo {
+/**
+ * @brief Limits of a NotificationThrottle.
+ */
+struct ThrottlePolicy {
+    /**
+     * The length of the window in which the notifications are counted. Each notification path has its own window,
+     * which starts with the first notification sent after the previous window has ended.
+     */
+    std::chrono::milliseconds window;
+    /**
+     * How many notifications with the same path can be sent within a window.
+     */
+    uint32_t burst;
+    /**
+     * Whether a notification identical to one already sent within the window is suppressed (even below the burst).
+     */
+    bool suppressDuplicates = true;
+};
+
+/**
+ * Creates a notification which summarizes the notifications suppressed within a window, see NotificationThrottle.
+ * @param path The path of the suppressed notifications.
+ * @param suppressed How many notifications were suppressed.
+ * @return The summary notification, or std::nullopt if nothing should be sent.
+ */
+using ThrottleSummaryCb = std::function<std::optional<libyang::DataNode>(const std::string& path, uint64_t suppressed)>;
+
+/**
+ * @brief Sends notifications, dropping floods of them.
+ *
+ * A faulty component can emit the same notification (e.g., a link flapping up and down) thousands of times per second,
+ * which floods all subscribers and the replay storage. A NotificationThrottle counts the notifications with the same
+ * path (libyang::DataNode::path of the notification node) within a time window and suppresses those beyond the
+ * ThrottlePolicy::burst, as well as duplicates of notifications already sent within the window.
+ *
+ * Once a window with suppressed notifications is over, a summary notification made by the ThrottleSummaryCb is sent
+ * instead of them. There is no timer thread; the summaries are sent by the next NotificationThrottle::send (or
+ * NotificationThrottle::flush) after the window is over.
+ *
+ * All methods are safe to call from multiple threads. The notifications are sent one at a time, since they all go
+ * through the same Session. The ThrottleSummaryCb is called without any lock held, so it may use the throttle.
+ */
+class NotificationThrottle {
+public:
+    NotificationThrottle(Session session, const ThrottlePolicy& policy, ThrottleSummaryCb summary = nullptr);
+
+    bool send(libyang::DataNode notification, const Wait wait = Wait::No, std::chrono::milliseconds timeout = std::chrono::milliseconds{0});
+    void flush(const bool force = false);
+    uint64_t suppressed() const;
+
+private:
+    struct Window {
+        std::chrono::steady_clock::time_point end;
+        uint32_t sent;
+        uint64_t suppressed;
+        std::set<std::string> seen;
+    };
+
+    // The path and the number of suppressed notifications of a window which has ended
+    using Ended = std::vector<std::pair<std::string, uint64_t>>;
+
+    void collectEnded(std::chrono::steady_clock::time_point now, bool force, Ended& ended);
+    std::map<std::string, Window>::iterator endWindow(std::map<std::string, Window>::iterator window, Ended& ended);
+    void sendSummaries(const Ended& ended);
+
+    Session m_session;
+    const ThrottlePolicy m_policy;
+    const ThrottleSummaryCb m_summary;
+
+    // Serializes the use of m_session, which is not safe to share between threads
+    std::mutex m_sendMtx;
+    mutable std::mutex m_mtx;
+    std::map<std::string, Window> m_windows;
+    std::chrono::steady_clock::time_point m_nextSweep;
+    uint64_t m_suppressed = 0;
+};
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+#pragma once
+
+#include <map>
+#include <memory>
+#include <span>
+#include <sysrepo-cpp/Session.hpp>
+
+struct ly_ctx;
+struct lysc_node;
+
+namespace sysrepo {
+/**
+ * @brief Builds output data (of an OperGetCb or an RpcActionCb) without parsing a path for every node.
+ *
+ * Creating each node with libyang::DataNode::newPath means parsing its path and looking up every step of it in the
+ * schema, which dominates the time spent on filling a large table. An OutputBuilder resolves the paths once, when they
+ * are registered via OutputBuilder::field (typically while subscribing), and then creates the nodes straight from the
+ * remembered schema nodes.
+ *
+ * The builder keeps the libyang context of the session acquired (`sr_session_acquire_context`) for as long as it exists,
+ * so that the schema stays the same. This blocks every change of the context (installing or removing modules, changing
+ * features, ...) until the builder is destroyed. Do not keep a builder across such a change; destroy it before the
+ * change and create a new one afterwards.
+ */
+class OutputBuilder {
+public:
+    /**
+     * A node registered with OutputBuilder::field.
+     */
+    struct Field {
+        size_t index;
+    };
+
+    /**
+     * Values of one node for a number of list instances, see OutputBuilder::createListInstances.
+     */
+    struct Column {
+        Field field;
+        std::span<const std::string> values;
+    };
+
+    OutputBuilder(Session session, const std::string& basePath, const libyang::InputOutputNodes nodes = libyang::InputOutputNodes::Input);
+
+    Field field(const std::string& relativePath);
+
+    libyang::DataNode createBase() const;
+    libyang::DataNode create(libyang::DataNode parent, const Field field, const std::optional<std::string>& value = std::nullopt) const;
+    libyang::DataNode createListInstance(libyang::DataNode parent, const Field list, const std::vector<std::string>& keys) const;
+    void createListInstances(libyang::DataNode parent, const Field list, std::span<const Column> columns) const;
+
+private:
+    std::span<const lysc_node* const> steps(libyang::DataNode parent, const Field field) const;
+
+    std::string m_basePath;
+    std::shared_ptr<const ly_ctx> m_ctx;
+    const lysc_node* m_base;
+    uint32_t m_options;
+    // The schema nodes on the way from the base node to each field
+    std::vector<std::vector<const lysc_node*>> m_fields;
+    std::map<std::string, size_t> m_paths;
+};
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+#pragma once
+
+#include <libyang-cpp/Context.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sysrepo {
+/**
+ * @brief A comparison of a list key (or a leaf-list value) with a literal, found in a predicate of the request XPath.
+ */
+struct KeyConstraint {
+    enum class Operator {
+        Equal,
+        NotEqual,
+        Less,
+        LessOrEqual,
+        Greater,
+        GreaterOrEqual,
+    };
+
+    std::string key; /**< Name of the key, without a module prefix. `.` for the value of a leaf-list. */
+    Operator op;
+    std::string value; /**< The literal without quotes. */
+
+    bool operator==(const KeyConstraint&) const = default;
+};
+
+/**
+ * @brief One step of the path in the request XPath.
+ */
+struct RequestedStep {
+    libyang::SchemaNode node;
+    std::vector<KeyConstraint> constraints; /**< All of these must hold for a list instance to be requested. */
+};
+
+/**
+ * @brief What an operational data request asks for, as parsed by parseRequestXPath.
+ *
+ * The request selects the instances of the node of the last step, and everything below them. Whatever the parser does
+ * not understand only makes the result broader, never narrower, so a provider which generates everything for which
+ * RequestedData::isRequested returns true never misses any requested data.
+ */
+struct RequestedData {
+    std::vector<RequestedStep> steps; /**< The path to the requested node. Empty if everything is requested. */
+    bool exact; /**< False if some part of the XPath was not understood and the request is broader than the XPath. */
+
+    bool isRequested(const libyang::SchemaNode& node) const;
+    bool isRequested(const libyang::SchemaNode& list, const std::vector<std::pair<std::string, std::string>>& keys) const;
+};
+
+RequestedData parseRequestXPath(const libyang::Context& ctx, const std::string& requestXPath);
+}
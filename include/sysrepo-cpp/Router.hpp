@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+#pragma once
+
+#include <memory>
+#include <set>
+#include <sysrepo-cpp/Session.hpp>
+#include <vector>
+
+struct ly_ctx;
+struct lysc_node;
+
+namespace sysrepo {
+/**
+ * A handler of a single kind of notification, see NotificationRouter.
+ * @param session An implicit session for the callback.
+ * @param type Type of the notification, either NotificationType::Realtime or NotificationType::Replay.
+ * @param notification The notification node itself (not the top-level node of its tree, for a notification nested in
+ * a container or a list).
+ * @param timestamp Time when the notification was generated.
+ */
+using RoutedNotifCb = std::function<void(Session session, const NotificationType type, const libyang::DataNode& notification, const NotificationTimeStamp timestamp)>;
+
+/**
+ * @brief Dispatches notifications of many modules to handlers of the individual notifications.
+ *
+ * A handler is registered for a schema path of a notification via NotificationRouter::on. The router subscribes to
+ * each module once, when the first handler for a notification of that module is registered; all of these
+ * subscriptions share a single subscription context. An incoming notification is dispatched by looking its schema node
+ * up in a hash map, without building or comparing any paths.
+ *
+ * The router keeps the libyang context of the session acquired (`sr_session_acquire_context`) for as long as it
+ * exists, so that the schema nodes stay valid. While a router exists, the context cannot be changed: installing or
+ * removing modules, changing features and similar operations on the connection block until the router is destroyed.
+ * Destroy the router before such a change and create a new one afterwards. Handlers can be registered at any time, even
+ * while notifications are being dispatched, but not from several threads at once.
+ */
+class NotificationRouter {
+public:
+    explicit NotificationRouter(Session session, ExceptionHandler handler = nullptr, const std::optional<FDHandling>& callbacks = std::nullopt);
+
+    void on(const std::string& notificationPath, RoutedNotifCb cb, const SubscribeOptions opts = SubscribeOptions::Default);
+
+private:
+    struct State;
+
+    Session m_session;
+    ExceptionHandler m_exceptionHandler;
+    std::optional<FDHandling> m_customEventLoopCbs;
+    std::shared_ptr<State> m_state;
+    std::set<std::string> m_subscribedModules;
+    std::optional<Subscription> m_sub;
+};
+
+/**
+ * A handler of a single RPC or action, see RpcRouter.
+ * @param session An implicit session for the callback.
+ * @param input The input of the operation. Points to the RPC/action node itself.
+ * @param parentKeys For an action of a list instance, the key nodes of all the list instances above the action, from
+ * the outermost one. Their typed values are available via libyang::DataNodeTerm::value. Empty for an RPC.
+ * @param event Either Event::RPC, or Event::Abort when a handler with a lower priority has failed.
+ * @param output The output of the operation, which the handler is supposed to fill. Points to the RPC/action node.
+ */
+using RoutedRpcCb = std::function<ErrorCode(Session session, const libyang::DataNode& input, const std::vector<libyang::DataNodeTerm>& parentKeys, const Event event, libyang::DataNode output)>;
+
+/**
+ * @brief Dispatches RPCs and actions to their handlers.
+ *
+ * A handler is registered for a schema path of an RPC or an action via RpcRouter::on. sysrepo needs a separate
+ * subscription for every RPC/action, but all of them share a single subscription context, and an incoming operation is
+ * dispatched by looking its schema node up in a hash map. Handlers therefore don't need to parse the path of the
+ * operation; for actions, the keys of the list instances which the action belongs to are passed to the handler.
+ *
+ * Like NotificationRouter, the router keeps the libyang context of the session acquired for as long as it exists, so
+ * that the schema nodes stay valid. The context cannot be changed (e.g., by installing a module) until the router is
+ * destroyed. Handlers can be registered at any time, even while operations are being dispatched, but not from several
+ * threads at once.
+ */
+class RpcRouter {
+public:
+    explicit RpcRouter(Session session, ExceptionHandler handler = nullptr, const std::optional<FDHandling>& callbacks = std::nullopt);
+
+    void on(const std::string& operationPath, RoutedRpcCb cb, uint32_t priority = 0, const SubscribeOptions opts = SubscribeOptions::Default);
+
+private:
+    struct State;
+
+    Session m_session;
+    ExceptionHandler m_exceptionHandler;
+    std::optional<FDHandling> m_customEventLoopCbs;
+    std::shared_ptr<State> m_state;
+    std::optional<Subscription> m_sub;
+};
+}
@@ -11,6 +11,7 @@
 #include <iosfwd>
 #include <memory>
 #include <optional>
+#include <span>
 #include <libyang-cpp/Context.hpp>
 #include <libyang-cpp/DataNode.hpp>
 #include <sysrepo-cpp/Enum.hpp>
@@ -23,6 +24,7 @@ namespace sysrepo {
 class Connection;
 class ChangeCollection;
 class Session;
+class SubscriptionGroup;
 
 /**
  * @brief Internal use only.
@@ -73,6 +75,25 @@ enum class Wait {
     No
 };
 
+/**
+ * @brief A notification which could not be sent, see Session::sendNotifications.
+ */
+struct NotificationFailure {
+    bool operator==(const NotificationFailure& other) const = default;
+    /**
+     * Position of the notification in the batch.
+     */
+    size_t index;
+    /**
+     * The error code associated with the error.
+     */
+    ErrorCode code;
+    /**
+     * The error message, including the errors reported by sysrepo.
+     */
+    std::string errorMessage;
+};
+
 sr_session_ctx_s* getRawSession(Session sess);
 
 /**
@@ -95,6 +116,7 @@ public:
     void copyConfig(const Datastore source, const std::optional<std::string>& moduleName = std::nullopt, std::chrono::milliseconds timeout = std::chrono::milliseconds{0});
     libyang::DataNode sendRPC(libyang::DataNode input, std::chrono::milliseconds timeout = std::chrono::milliseconds{0});
     void sendNotification(libyang::DataNode notification, const Wait wait, std::chrono::milliseconds timeout = std::chrono::milliseconds{0});
+    std::vector<NotificationFailure> sendNotifications(std::span<const libyang::DataNode> notifications, const Wait wait, std::chrono::milliseconds timeout = std::chrono::milliseconds{0});
     void replaceConfig(std::optional<libyang::DataNode> config, const std::optional<std::string>& module = std::nullopt, std::chrono::milliseconds timeout = std::chrono::milliseconds{0});
 
     void setNacmUser(const std::string& user);
@@ -111,6 +133,14 @@ public:
             const SubscribeOptions opts = SubscribeOptions::Default,
             ExceptionHandler handler = nullptr,
             const std::optional<FDHandling>& callbacks = std::nullopt);
+    [[nodiscard]] Subscription onModuleChangeAsync(
+            const std::string& moduleName,
+            AsyncModuleChangeCb cb,
+            const std::optional<std::string>& xpath = std::nullopt,
+            uint32_t priority = 0,
+            const SubscribeOptions opts = SubscribeOptions::Default,
+            ExceptionHandler handler = nullptr,
+            const std::optional<FDHandling>& callbacks = std::nullopt);
     [[nodiscard]] Subscription onOperGet(
             const std::string& moduleName,
             OperGetCb cb,
@@ -143,6 +173,11 @@ public:
 
     std::string getOriginatorName() const;
     void setOriginatorName(const std::string& originatorName);
+    void pushOriginatorData(const std::string& data);
+    std::optional<std::string> getOriginatorData(uint32_t idx) const;
+
+    void setTraceId(const std::string& traceId);
+    std::optional<std::string> getTraceId() const;
 
     Connection getConnection();
     const libyang::Context getContext() const;
@@ -151,6 +186,7 @@ public:
 
 private:
     friend Connection;
+    friend SubscriptionGroup;
     friend Session wrapUnmanagedSession(sr_session_ctx_s* session);
     friend sr_session_ctx_s* getRawSession(Session sess);
 
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+#pragma once
+
+#include <map>
+#include <sysrepo-cpp/Session.hpp>
+#include <vector>
+
+namespace sysrepo {
+/**
+ * @brief Runtime statistics of the sysrepo-cpp library within the current process.
+ *
+ * Retrieved via sysrepo::libraryStats.
+ */
+struct LibraryStats {
+    /**
+     * Number of sessions started via Connection::sessionStart.
+     */
+    uint64_t sessionsCreated;
+    /**
+     * Number of sysrepo subscription contexts currently held by Subscription instances.
+     */
+    uint64_t subscriptionsAlive;
+    /**
+     * Number of `sr_data_t` handles (as returned by, e.g., Session::getData) which are still referenced.
+     */
+    uint64_t outstandingData;
+    /**
+     * Errors reported by the C library which were turned into exceptions, by their ErrorCode.
+     */
+    std::map<ErrorCode, uint64_t> errors;
+    /**
+     * Statistics of all callbacks of all live Subscription instances.
+     */
+    std::vector<CallbackStats> callbacks;
+};
+
+LibraryStats libraryStats();
+
+[[nodiscard]] Subscription publishLibraryStats(
+        Session session,
+        const SubscribeOptions opts = SubscribeOptions::Default,
+        ExceptionHandler handler = nullptr,
+        const std::optional<FDHandling>& callbacks = std::nullopt);
+}
@@ -6,14 +6,17 @@
  * SPDX-License-Identifier: BSD-3-Clause
 */
 #pragma once
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <functional>
 #include <libyang-cpp/DataNode.hpp>
-#include <list>
+#include <map>
 #include <memory>
 #include <optional>
 #include <sysrepo-cpp/Enum.hpp>
 #include <variant>
+#include <vector>
 
 struct sr_session_ctx_s;
 struct sr_subscription_ctx_s;
@@ -22,6 +25,11 @@ struct sr_change_iter_s;
 namespace sysrepo {
 class ChangeCollection;
 class Session;
+struct CallbackCounters;
+class Subscription;
+class SubscriptionGroup;
+template <typename T>
+class BoundedQueue;
 
 /**
  * @brief Contains info about a change in datastore.
@@ -84,6 +92,59 @@ struct Change {
     bool previousDefault;
 };
 
+/**
+ * @brief A self-contained copy of a Change.
+ *
+ * Unlike Change, this does not reference the data tree of the implicit session, so it can outlive the callback.
+ */
+struct ChangeRecord {
+    ChangeOperation operation;
+    /**
+     * The path of the affected node.
+     */
+    std::string path;
+    /**
+     * The value of the affected node, if it is a leaf or a leaf-list. For deleted nodes, this is the deleted value.
+     */
+    std::optional<std::string> value;
+    /**
+     * See Change::previousValue.
+     */
+    std::optional<std::string> previousValue;
+    /**
+     * See Change::previousList.
+     */
+    std::optional<std::string> previousList;
+    /**
+     * See Change::previousDefault.
+     */
+    bool previousDefault;
+
+    bool operator==(const ChangeRecord&) const = default;
+};
+
+/**
+ * @brief All changes of a module made by a single transaction.
+ */
+struct ChangeSet {
+    std::string moduleName;
+    uint32_t requestId;
+    std::vector<ChangeRecord> changes;
+};
+
+/**
+ * @brief A queue for handing ChangeSet instances over to another thread, see Subscription::onModuleChangeDeferred.
+ *
+ * Defined in sysrepo-cpp/utils/queue.hpp.
+ */
+using ChangeQueue = BoundedQueue<ChangeSet>;
+
+/**
+ * A callback for Subscription::onModuleChangeCoalesced.
+ * @param changes The merged changes of all transactions within the window.
+ */
+using CoalescedChangeCb = std::function<void(const ChangeSet& changes)>;
+
 /**
  * @brief An iterator pointing to a single change associated with a ChangeCollection.
  */
@@ -138,6 +199,32 @@ private:
     std::shared_ptr<sr_session_ctx_s> m_sess;
 };
 
+/**
+ * @brief All changes within a single list instance, see sysrepo::groupByListInstance.
+ */
+struct ListInstanceChange {
+    /**
+     * Created, Deleted or Moved if the list instance itself was created, deleted or moved. Modified if only some of the
+     * nodes within it have changed.
+     */
+    ChangeOperation operation;
+    /**
+     * The list instance node.
+     */
+    libyang::DataNode instance;
+    /**
+     * Names and values of the keys of the list instance, in the schema order.
+     */
+    std::vector<std::pair<std::string, std::string>> keys;
+    /**
+     * Changes of the nodes within this list instance, in the order in which sysrepo reported them. Nodes which belong to
+     * a nested list instance are not included here, that instance gets its own ListInstanceChange.
+     */
+    std::vector<Change> changes;
+};
+
+std::vector<ListInstanceChange> groupByListInstance(const ChangeCollection& changes);
+
 /**
  * Timestamp used in notification callbacks. Corresponds to the time when the notification was created.
  */
@@ -155,6 +242,49 @@ using NotificationTimeStamp = std::chrono::time_point<std::chrono::system_clock,
  */
 using ModuleChangeCb = std::function<ErrorCode(Session session, uint32_t subscriptionId, const std::string& moduleName, const std::optional<std::string>& subXPath, Event event, uint32_t requestId)>;
 
+struct PendingChange;
+
+/**
+ * @brief Reports the result of an AsyncModuleChangeCb.
+ *
+ * Can be copied and completed from any thread, but only once.
+ */
+class ChangeCompletion {
+public:
+    void complete(ErrorCode result);
+
+private:
+    friend Subscription;
+    explicit ChangeCompletion(std::shared_ptr<PendingChange> pending);
+
+    std::shared_ptr<PendingChange> m_pending;
+};
+
+/**
+ * A callback type for module change subscriptions which finish their work asynchronously.
+ *
+ * The parameters are the same as for ModuleChangeCb. Instead of returning an ErrorCode, the callback passes the
+ * `completion` to whatever does the actual work (e.g., a thread pool) and returns. Until ChangeCompletion::complete is
+ * called, the event stays shelved (see ErrorCode::CallbackShelve) and the event loop is free to handle other events.
+ * Once completed, the event loop is woken up, the event is delivered again and the result is passed to sysrepo. Only
+ * available with a custom event loop, see Subscription::onModuleChangeAsync.
+ *
+ * The implicit session is only valid during the callback, so everything that the asynchronous part needs (e.g., the
+ * output of Session::getChanges) has to be extracted before returning.
+ */
+using AsyncModuleChangeCb = std::function<void(Session session, uint32_t subscriptionId, const std::string& moduleName, const std::optional<std::string>& subXPath, Event event, uint32_t requestId, ChangeCompletion completion)>;
+
+/**
+ * A callback type for module change subscriptions with a shadow tree, see Subscription::onModuleChangeShadowed.
+ *
+ * The first six parameters are the same as for ModuleChangeCb.
+ * @param oldTree The data of the module before this change (std::nullopt if there were none).
+ * @param newTree The data of the module with this change applied (std::nullopt if there are none).
+ *
+ * Both trees are owned by the library and must not be modified.
+ */
+using ShadowModuleChangeCb = std::function<ErrorCode(Session session, uint32_t subscriptionId, const std::string& moduleName, const std::optional<std::string>& subXPath, Event event, uint32_t requestId, const std::optional<libyang::DataNode>& oldTree, const std::optional<libyang::DataNode>& newTree)>;
+
 /**
  * A callback for OperGet subscriptions.
  * @param session An implicit session for the callback.
@@ -189,6 +319,58 @@ using RpcActionCb = std::function<ErrorCode(Session session, uint32_t subscripti
  */
 using NotifCb = std::function<void(Session session, uint32_t subscriptionId, const NotificationType type, const std::optional<libyang::DataNode> notificationTree, const NotificationTimeStamp timestamp)>;
 
+/**
+ * @brief A copy of a received notification, see Subscription::onNotificationQueued.
+ */
+struct ReceivedNotification {
+    NotificationType type;
+    /**
+     * The notification, owned by this object. std::nullopt for events with no YANG-level notification.
+     */
+    std::optional<libyang::DataNode> tree;
+    NotificationTimeStamp timestamp;
+};
+
+/**
+ * @brief What happens with a notification which does not fit into a full NotificationRing.
+ */
+enum class OverflowPolicy {
+    DropOldest, /**< The oldest notification in the ring is dropped to make space. */
+    DropNewest, /**< The new notification is dropped. */
+    Block, /**< The subscription thread waits until the consumer makes some space. */
+};
+
+/**
+ * @brief A bounded buffer of received notifications, filled by the subscription thread and drained by the application
+ * at its own pace. See Subscription::onNotificationQueued.
+ *
+ * The buffer is lock-free (see BoundedQueue); any number of threads can pop from it.
+ */
+class NotificationRing {
+public:
+    NotificationRing(size_t capacity, OverflowPolicy policy);
+    ~NotificationRing();
+    NotificationRing(const NotificationRing&) = delete;
+    NotificationRing& operator=(const NotificationRing&) = delete;
+
+    void push(ReceivedNotification&& notification);
+    std::optional<ReceivedNotification> tryPop();
+    ReceivedNotification pop();
+
+    size_t capacity() const;
+    uint64_t dropped() const;
+    size_t highWaterMark() const;
+
+private:
+    void popped();
+
+    std::unique_ptr<BoundedQueue<ReceivedNotification>> m_queue;
+    const OverflowPolicy m_policy;
+    std::atomic<size_t> m_size{0};
+    std::atomic<size_t> m_highWaterMark{0};
+    std::atomic<uint64_t> m_dropped{0};
+};
+
 /**
  * Exception handler type for handling exceptions thrown in user callbacks.
  */
@@ -201,9 +383,172 @@ template <typename Callback>
 struct PrivData {
     Callback callback;
     ExceptionHandler* exceptionHandler;
+    std::shared_ptr<CallbackCounters> counters;
+};
+
+template<typename Callback> PrivData(Callback, std::function<void(std::exception& ex)>*, std::shared_ptr<CallbackCounters>) -> PrivData<Callback>;
+
+/**
+ * @brief For internal use only.
+ *
+ * Storage of the callbacks of a Subscription. The C-style callbacks take addresses of the stored items, so these need to
+ * be stable. The items are allocated in chunks which never move, and the slot of a removed item is reused by the next
+ * insertion.
+ */
+template <typename T>
+class CallbackSlab {
+public:
+    static constexpr size_t ChunkSize = 16;
+
+    template <typename... Args>
+    size_t emplace(Args&&... args)
+    {
+        if (m_free.empty()) {
+            m_chunks.emplace_back(std::make_unique<Chunk>());
+            auto base = (m_chunks.size() - 1) * ChunkSize;
+            for (size_t i = ChunkSize; i > 0; i--) {
+                m_free.push_back(base + i - 1);
+            }
+        }
+
+        auto slot = m_free.back();
+        at(slot).emplace(std::forward<Args>(args)...);
+        m_free.pop_back();
+        return slot;
+    }
+
+    T& operator[](size_t slot)
+    {
+        return *at(slot);
+    }
+
+    void erase(size_t slot)
+    {
+        at(slot).reset();
+        m_free.push_back(slot);
+    }
+
+    template <typename Predicate>
+    void eraseIf(Predicate pred)
+    {
+        for (size_t slot = 0; slot < m_chunks.size() * ChunkSize; slot++) {
+            if (at(slot) && pred(*at(slot))) {
+                erase(slot);
+            }
+        }
+    }
+
+    template <typename Function>
+    void forEach(Function fn) const
+    {
+        for (const auto& chunk : m_chunks) {
+            for (const auto& item : *chunk) {
+                if (item) {
+                    fn(*item);
+                }
+            }
+        }
+    }
+
+private:
+    using Chunk = std::array<std::optional<T>, ChunkSize>;
+
+    std::optional<T>& at(size_t slot)
+    {
+        return (*m_chunks[slot / ChunkSize])[slot % ChunkSize];
+    }
+
+    std::vector<std::unique_ptr<Chunk>> m_chunks;
+    std::vector<size_t> m_free;
+};
+
+/**
+ * @brief Distribution of the time spent in a user callback.
+ *
+ * Bucket `0` counts invocations which took less than one microsecond. Bucket `i` counts invocations which took at least
+ * `2^(i-1)` and less than `2^i` microseconds. The last bucket also includes everything which took even longer.
+ */
+struct LatencyHistogram {
+    static constexpr size_t BucketCount = 24;
+    std::array<uint64_t, BucketCount> buckets;
+    /**
+     * Time spent in all invocations together.
+     */
+    std::chrono::nanoseconds total;
+    /**
+     * The slowest invocation so far.
+     */
+    std::chrono::nanoseconds max;
+};
+
+/**
+ * @brief Counters describing invocations of a user callback.
+ */
+struct InvocationStats {
+    uint64_t invocations;
+    /**
+     * Number of invocations which ended with an exception.
+     */
+    uint64_t exceptions;
+    /**
+     * How many times was each ErrorCode returned to sysrepo. Exceptions are counted as ErrorCode::OperationFailed.
+     * Notification callbacks do not return anything, so this is always empty for them.
+     */
+    std::map<ErrorCode, uint64_t> errorCodes;
+    LatencyHistogram latency;
+};
+
+/**
+ * @brief Runtime statistics of one callback registered in a Subscription.
+ *
+ * Retrieved via Subscription::stats.
+ */
+struct CallbackStats {
+    /**
+     * The sysrepo-level subscription ID of this callback.
+     */
+    uint32_t subscriptionId;
+    CallbackType type;
+    /**
+     * The module name for module change, operational and notification subscriptions, the RPC/action path for
+     * RPC/action subscriptions.
+     */
+    std::string name;
+    /**
+     * The XPath which was used for subscribing (if any).
+     */
+    std::optional<std::string> xpath;
+    /**
+     * Invocations split by the Event they were handling. Only filled for module change and RPC/action callbacks.
+     */
+    std::map<Event, InvocationStats> perEvent;
+    /**
+     * All invocations of this callback.
+     */
+    InvocationStats total;
+    /**
+     * Requests which were answered with no data because of load shedding, see Subscription::setLoadShedding. These are
+     * not counted as invocations.
+     */
+    uint64_t shed;
 };
 
-template<typename Callback> PrivData(Callback, std::function<void(std::exception& ex)>*) -> PrivData<Callback>;
+/**
+ * @brief Describes when an operational data provider is considered overloaded.
+ *
+ * See Subscription::setLoadShedding.
+ */
+struct LoadSheddingPolicy {
+    /**
+     * An invocation of the callback which takes longer than this starts the shedding.
+     */
+    std::chrono::microseconds latencyThreshold;
+    /**
+     * How long to keep answering with no data once the threshold was crossed. The next request after this period is
+     * passed to the callback again, and its latency decides whether the shedding continues.
+     */
+    std::chrono::milliseconds cooldown;
+};
 
 /**
  * @brief Contains callback for registering a Subscription to a custom event loop.
@@ -222,6 +567,30 @@ struct FDHandling {
     std::function<void(int fd)> unregisterFd;
 };
 
+/**
+ * @brief Keeps a subscription (or the subscription thread) suspended.
+ *
+ * Created by Subscription::suspendScoped and Subscription::suspendThreadScoped. Resumes the subscription when destroyed.
+ * The guard does not keep the subscription alive; if the Subscription is destroyed first, destroying the guard does
+ * nothing.
+ */
+class SuspendGuard {
+public:
+    ~SuspendGuard();
+    SuspendGuard(const SuspendGuard&) = delete;
+    SuspendGuard& operator=(const SuspendGuard&) = delete;
+    SuspendGuard(SuspendGuard&&) noexcept;
+    SuspendGuard& operator=(SuspendGuard&&) noexcept;
+
+private:
+    friend Subscription;
+    SuspendGuard(std::shared_ptr<sr_subscription_ctx_s> sub, std::optional<uint32_t> subscriptionId);
+
+    std::weak_ptr<sr_subscription_ctx_s> m_sub;
+    // std::nullopt means that the whole thread is suspended
+    std::optional<uint32_t> m_subscriptionId;
+};
+
 /**
  * @brief Manages lifetime of subscriptions.
  */
@@ -234,7 +603,12 @@ public:
     Subscription& operator=(Subscription&&) noexcept;
 
     void onModuleChange(const std::string& moduleName, ModuleChangeCb cb, const std::optional<std::string>& xpath = std::nullopt, uint32_t priority = 0, const SubscribeOptions opts = SubscribeOptions::Default);
+    void onModuleChangeDeferred(const std::string& moduleName, std::shared_ptr<ChangeQueue> queue, const std::optional<std::string>& xpath = std::nullopt, uint32_t priority = 0, const SubscribeOptions opts = SubscribeOptions::Default);
+    void onModuleChangeCoalesced(const std::string& moduleName, CoalescedChangeCb cb, std::chrono::milliseconds window, const std::optional<std::string>& xpath = std::nullopt, uint32_t priority = 0, const SubscribeOptions opts = SubscribeOptions::Default);
+    void onModuleChangeShadowed(const std::string& moduleName, ShadowModuleChangeCb cb, const std::optional<std::string>& xpath = std::nullopt, uint32_t priority = 0, const SubscribeOptions opts = SubscribeOptions::Default);
+    void onModuleChangeAsync(const std::string& moduleName, AsyncModuleChangeCb cb, const std::optional<std::string>& xpath = std::nullopt, uint32_t priority = 0, const SubscribeOptions opts = SubscribeOptions::Default);
     void onOperGet(const std::string& moduleName, OperGetCb cb, const std::optional<std::string>& xpath, const SubscribeOptions opts = SubscribeOptions::Default);
+    void onOperGetSharded(const std::string& moduleName, std::vector<OperGetCb> shards, const std::optional<std::string>& xpath, const SubscribeOptions opts = SubscribeOptions::Default);
     void onRPCAction(const std::string& xpath, RpcActionCb cb, uint32_t priority = 0, const SubscribeOptions opts = SubscribeOptions::Default);
     void onNotification(
             const std::string& moduleName,
@@ -243,21 +617,47 @@ public:
             const std::optional<NotificationTimeStamp>& startTime = std::nullopt,
             const std::optional<NotificationTimeStamp>& stopTime = std::nullopt,
             const SubscribeOptions opts = SubscribeOptions::Default);
+    void onNotificationQueued(
+            const std::string& moduleName,
+            std::shared_ptr<NotificationRing> ring,
+            const std::optional<std::string>& xpath = std::nullopt,
+            const std::optional<NotificationTimeStamp>& startTime = std::nullopt,
+            const std::optional<NotificationTimeStamp>& stopTime = std::nullopt,
+            const SubscribeOptions opts = SubscribeOptions::Default);
+
+    void unsubscribe(uint32_t subscriptionId);
+
+    void suspend(uint32_t subscriptionId);
+    void resume(uint32_t subscriptionId);
+    bool isSuspended(uint32_t subscriptionId) const;
+    [[nodiscard]] SuspendGuard suspendScoped(uint32_t subscriptionId);
+
+    void suspendThread();
+    void resumeThread();
+    [[nodiscard]] SuspendGuard suspendThreadScoped();
+
+    void setLoadShedding(uint32_t subscriptionId, const std::optional<LoadSheddingPolicy>& policy);
+
+    void setAsyncTeardown(bool enabled);
+
+    std::vector<CallbackStats> stats() const;
 private:
     int eventPipe() const;
     void saveContext(sr_subscription_ctx_s* ctx);
+    uint32_t lastSubscriptionId() const;
 
     friend Session;
+    friend SubscriptionGroup;
     explicit Subscription(std::shared_ptr<sr_session_ctx_s> sess, ExceptionHandler handler, const std::optional<FDHandling>& callbacks);
 
     std::optional<FDHandling> m_customEventLoopCbs;
 
     // This saves the users' callbacks. The C-style callback takes addresses of these, so the addresses need to be
-    // stable (therefore, we use an std::list).
-    std::list<PrivData<ModuleChangeCb>> m_moduleChangeCbs;
-    std::list<PrivData<OperGetCb>> m_operGetCbs;
-    std::list<PrivData<RpcActionCb>> m_RPCActionCbs;
-    std::list<PrivData<NotifCb>> m_notificationCbs;
+    // stable (therefore, we use a CallbackSlab).
+    CallbackSlab<PrivData<ModuleChangeCb>> m_moduleChangeCbs;
+    CallbackSlab<PrivData<OperGetCb>> m_operGetCbs;
+    CallbackSlab<PrivData<RpcActionCb>> m_RPCActionCbs;
+    CallbackSlab<PrivData<NotifCb>> m_notificationCbs;
 
     // Need a stable address, so need to save it on the heap.
     std::shared_ptr<ExceptionHandler> m_exceptionHandler;
@@ -266,6 +666,13 @@ private:
 
     std::shared_ptr<sr_subscription_ctx_s> m_sub;
 
+    // Wakeup FDs of onModuleChangeAsync, registered with the custom event loop.
+    std::vector<int> m_wakeupFds;
+
     bool m_didNacmInit;
+    bool m_asyncTeardown;
 };
+
+void unsubscribeAll(std::vector<Subscription> subscriptions, unsigned parallelism = 16);
+void waitForBackgroundTeardown();
 }
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+#pragma once
+
+#include <memory>
+#include <sysrepo-cpp/Session.hpp>
+
+namespace sysrepo {
+class SubscriptionGroup;
+
+/**
+ * @brief Keeps a single callback registered in a SubscriptionGroup.
+ *
+ * The callback is unsubscribed when the handle is destroyed. The other callbacks in the group are not affected.
+ */
+class SubscriptionHandle {
+public:
+    ~SubscriptionHandle();
+    SubscriptionHandle(const SubscriptionHandle&) = delete;
+    SubscriptionHandle& operator=(const SubscriptionHandle&) = delete;
+    SubscriptionHandle(SubscriptionHandle&&) noexcept;
+    SubscriptionHandle& operator=(SubscriptionHandle&&) noexcept;
+
+    uint32_t subscriptionId() const;
+    void unsubscribe();
+
+private:
+    struct GroupState;
+    friend SubscriptionGroup;
+    SubscriptionHandle(std::shared_ptr<GroupState> group, uint32_t subscriptionId);
+
+    std::shared_ptr<GroupState> m_group;
+    uint32_t m_subscriptionId;
+};
+
+/**
+ * @brief Lets independent components share one sysrepo subscription context (and therefore one event-processing thread).
+ *
+ * Every Session::onModuleChange and friends creates a new subscription context with its own thread. With many
+ * components in a single process, each of them owning its own Subscription, this quickly adds up. A SubscriptionGroup
+ * owns a single Subscription and hands out a SubscriptionHandle for each registered callback instead. The callbacks can
+ * be added and removed independently of each other; the context stays alive as long as the group or any of its handles
+ * exist.
+ *
+ * All callbacks in the group share the exception handler and, when SubscribeOptions::NoThread is used, the FDHandling
+ * callbacks. It is safe to call the methods of a group (and to destroy the handles) from multiple threads. A callback
+ * must not add or remove callbacks of its own group, though.
+ */
+class SubscriptionGroup {
+public:
+    explicit SubscriptionGroup(Session session, ExceptionHandler handler = nullptr, const std::optional<FDHandling>& callbacks = std::nullopt);
+
+    [[nodiscard]] SubscriptionHandle onModuleChange(
+            const std::string& moduleName,
+            ModuleChangeCb cb,
+            const std::optional<std::string>& xpath = std::nullopt,
+            uint32_t priority = 0,
+            const SubscribeOptions opts = SubscribeOptions::Default);
+    [[nodiscard]] SubscriptionHandle onOperGet(
+            const std::string& moduleName,
+            OperGetCb cb,
+            const std::optional<std::string>& xpath = std::nullopt,
+            const SubscribeOptions opts = SubscribeOptions::Default);
+    [[nodiscard]] SubscriptionHandle onRPCAction(
+            const std::string& xpath,
+            RpcActionCb cb,
+            uint32_t priority = 0,
+            const SubscribeOptions opts = SubscribeOptions::Default);
+    [[nodiscard]] SubscriptionHandle onNotification(
+            const std::string& moduleName,
+            NotifCb cb,
+            const std::optional<std::string>& xpath = std::nullopt,
+            const std::optional<NotificationTimeStamp>& startTime = std::nullopt,
+            const std::optional<NotificationTimeStamp>& stopTime = std::nullopt,
+            const SubscribeOptions opts = SubscribeOptions::Default);
+
+    std::vector<CallbackStats> stats() const;
+
+private:
+    std::shared_ptr<SubscriptionHandle::GroupState> m_state;
+};
+}
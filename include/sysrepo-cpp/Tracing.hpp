@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sysrepo-cpp/Enum.hpp>
+
+namespace sysrepo {
+/**
+ * @brief Describes an operation which is about to be traced.
+ *
+ * All string views are only valid during the Tracer::startSpan call.
+ */
+struct SpanInfo {
+    /**
+     * Name of the operation, e.g., `Session::applyChanges` or `ModuleChangeCb`.
+     */
+    std::string_view operation;
+    /**
+     * The sysrepo-level ID of the session which performs the operation. For callbacks, this is the implicit session.
+     */
+    uint32_t sessionId;
+    /**
+     * The path, module name or RPC/action path the operation works with, if any.
+     */
+    std::optional<std::string_view> target;
+    /**
+     * The event which is being handled (only for module change and RPC/action callbacks).
+     */
+    std::optional<Event> event;
+    /**
+     * The sysrepo request ID (only for callbacks).
+     */
+    std::optional<uint32_t> requestId;
+    /**
+     * Trace ID set via Session::setTraceId, either on this session or, for callbacks, by the originator of the event.
+     */
+    std::optional<std::string> traceId;
+};
+
+/**
+ * @brief Hooks which are called around Session operations and user callbacks.
+ *
+ * Both hooks are called from whichever thread performs the operation, so they must be thread-safe. They must not
+ * throw.
+ */
+struct Tracer {
+    /**
+     * Called when an operation starts. The returned value is an arbitrary span ID which is passed to #endSpan.
+     */
+    std::function<uint64_t(const SpanInfo& span)> startSpan;
+    /**
+     * Called when an operation finishes. If the operation ended with an exception, `result` is
+     * ErrorCode::OperationFailed, unless a more specific code is known.
+     */
+    std::function<void(uint64_t spanId, ErrorCode result)> endSpan;
+};
+
+void setTracer(std::optional<Tracer> tracer);
+}
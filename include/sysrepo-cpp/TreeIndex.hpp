@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+#pragma once
+
+#include <libyang-cpp/DataNode.hpp>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sysrepo {
+/**
+ * @brief The kind of a secondary index in a TreeIndex.
+ */
+enum class IndexKind {
+    Hash, /**< Constant-time exact lookups. */
+    Sorted, /**< Logarithmic exact lookups, plus range lookups. Numbers are ordered numerically, other values as strings. */
+};
+
+/**
+ * @brief Secondary indexes over the instances of a list in a data tree (e.g., one returned by Session::getData).
+ *
+ * libyang looks list instances up by their keys quickly, but a lookup by any other leaf (an interface by its
+ * `if-index`, a neighbor by its address) means a linear scan over all instances. A TreeIndex scans the instances once
+ * per indexed leaf and answers these lookups from then on.
+ *
+ * The values are looked up by their canonical string form, i.e., as returned by libyang::DataNodeTerm::valueStr. The
+ * index does not track changes to the tree; when the tree is modified or replaced, call TreeIndex::invalidate (and
+ * build a new index), otherwise the lookups return stale or dangling nodes.
+ *
+ * The returned nodes share the reference tracking of the tree, just like any other libyang::DataNode. Therefore, the
+ * index is not thread-safe: it must not be used from multiple threads concurrently, not even for lookups.
+ */
+class TreeIndex {
+public:
+    TreeIndex(libyang::DataNode tree, const std::string& listXPath);
+
+    void addIndex(const std::string& leafPath, const IndexKind kind = IndexKind::Hash, const unsigned parallelism = 1);
+    std::vector<libyang::DataNode> find(const std::string& leafPath, const std::string& value) const;
+    std::vector<libyang::DataNode> findRange(const std::string& leafPath, const std::string& from, const std::string& to) const;
+
+    void invalidate();
+    bool isValid() const;
+
+private:
+    struct Index {
+        IndexKind kind;
+        // integers and decimal64 values are ordered numerically in the sorted index
+        bool numeric;
+        // both map a value to a position in m_instances
+        std::unordered_multimap<std::string, size_t> hashed;
+        std::vector<std::pair<std::string, size_t>> sorted;
+    };
+
+    const Index& index(const std::string& leafPath) const;
+
+    std::optional<libyang::DataNode> m_tree;
+    std::vector<libyang::DataNode> m_instances;
+    std::map<std::string, Index> m_indexes;
+};
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+#pragma once
+
+#include <concepts>
+#include <libyang-cpp/DataNode.hpp>
+#include <string>
+#include <vector>
+
+struct lyd_node;
+
+namespace sysrepo {
+/**
+ * @brief A prebuilt data tree of a notification or an RPC/action input, reused for many sends.
+ *
+ * Building the same tree from string paths before each Session::sendNotification or Session::sendRPC is wasteful when
+ * only a few leaf values differ between the sends. A TreeTemplate takes the tree built once (with placeholder values),
+ * remembers the leaves which vary, and changes just their values in place (`lyd_change_term`). TreeTemplate::reset
+ * puts the placeholder values back.
+ *
+ * The tree must not be changed structurally (nodes added or removed) while the template is in use, and the template is
+ * not safe to use from several threads at once.
+ */
+class TreeTemplate {
+public:
+    /**
+     * A leaf of the tree registered with TreeTemplate::slot.
+     */
+    struct Slot {
+        size_t index;
+    };
+
+    explicit TreeTemplate(libyang::DataNode tree);
+
+    Slot slot(const std::string& path);
+
+    void set(const Slot slot, const std::string& value);
+    /**
+     * Sets a leaf of an integer or a boolean type.
+     */
+    template <std::integral T>
+    void set(const Slot slot, T value)
+    {
+        if constexpr (std::same_as<T, bool>) {
+            set(slot, std::string{value ? "true" : "false"});
+        } else {
+            set(slot, std::to_string(value));
+        }
+    }
+    void reset();
+
+    libyang::DataNode tree() const;
+
+private:
+    libyang::DataNode m_tree;
+    std::vector<lyd_node*> m_leaves;
+    std::vector<std::string> m_placeholders;
+    std::vector<bool> m_changed;
+};
+}
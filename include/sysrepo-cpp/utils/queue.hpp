@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+namespace sysrepo {
+/**
+ * @brief A bounded lock-free queue with a fixed, preallocated capacity.
+ *
+ * Any number of threads can push and pop concurrently (this is Dmitry Vyukov's bounded MPMC queue). Neither pushing nor
+ * popping takes a lock or allocates, except for whatever moving `T` into and out of the queue does. The blocking
+ * variants BoundedQueue::push and BoundedQueue::pop only block when the queue is full or empty, respectively, and they
+ * sleep (rather than spin) while doing so.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    /**
+     * @param capacity The maximal number of items in the queue, rounded up to a power of two.
+     */
+    explicit BoundedQueue(size_t capacity)
+        : m_mask(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1)
+        , m_cells(std::make_unique<Cell[]>(m_mask + 1))
+    {
+        for (size_t i = 0; i <= m_mask; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * Pushes an item unless the queue is full.
+     *
+     * @return true if the item was pushed, false if the queue is full (`item` is left untouched in that case).
+     */
+    bool tryPush(T&& item)
+    {
+        auto pos = m_enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &m_cells[pos & m_mask];
+            auto seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data.emplace(std::move(item));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        m_published.fetch_add(1, std::memory_order_release);
+        m_published.notify_one();
+        return true;
+    }
+
+    /**
+     * Pushes an item. If the queue is full, sleeps until a consumer makes some space.
+     */
+    void push(T&& item)
+    {
+        while (true) {
+            auto consumed = m_consumed.load(std::memory_order_acquire);
+            if (tryPush(std::move(item))) {
+                return;
+            }
+            m_consumed.wait(consumed, std::memory_order_acquire);
+        }
+    }
+
+    /**
+     * Pops an item, unless the queue is empty.
+     */
+    std::optional<T> tryPop()
+    {
+        auto pos = m_dequeuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &m_cells[pos & m_mask];
+            auto seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return std::nullopt;
+            } else {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        std::optional<T> res{std::move(cell->data)};
+        cell->data.reset();
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        m_consumed.fetch_add(1, std::memory_order_release);
+        m_consumed.notify_one();
+        return res;
+    }
+
+    /**
+     * Pops an item. If the queue is empty, sleeps until something is pushed.
+     */
+    T pop()
+    {
+        while (true) {
+            auto published = m_published.load(std::memory_order_acquire);
+            if (auto item = tryPop()) {
+                return std::move(*item);
+            }
+            m_published.wait(published, std::memory_order_acquire);
+        }
+    }
+
+    size_t capacity() const
+    {
+        return m_mask + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        std::optional<T> data;
+    };
+
+    const size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+    // Producers and consumers each hammer their own position, so keep them on separate cache lines.
+    alignas(64) std::atomic<size_t> m_enqueuePos{0};
+    alignas(64) std::atomic<size_t> m_dequeuePos{0};
+    // Bumped after an item becomes visible, so that BoundedQueue::pop has something to wait on.
+    alignas(64) std::atomic<uint32_t> m_published{0};
+    // Bumped after a cell becomes free again, so that BoundedQueue::push has something to wait on.
+    alignas(64) std::atomic<uint32_t> m_consumed{0};
+};
+}
@@ -13,6 +13,7 @@ extern "C" {
 #include <sysrepo-cpp/utils/exception.hpp>
 #include "utils/enum.hpp"
 #include "utils/exception.hpp"
+#include "utils/stats.hpp"
 #include "utils/utils.hpp"
 
 namespace sysrepo {
@@ -54,6 +55,7 @@ Session Connection::sessionStart(sysrepo::Datastore datastore)
     auto res = sr_session_start(ctx.get(), toDatastore(datastore), &sess);
 
     throwIfError(res, "Couldn't start sysrepo session");
+    libraryCounters().sessionsCreated.fetch_add(1, std::memory_order_relaxed);
     return Session{sess, ctx};
 }
 
@@ -103,4 +103,20 @@ std::ostream& operator<<(std::ostream& os, const ErrorCode& err)
     os << stringify(err);
     return os;
 }
+
+std::ostream& operator<<(std::ostream& os, const CallbackType& type)
+{
+    switch (type) {
+    case sysrepo::CallbackType::ModuleChange:
+        return os << "sysrepo::CallbackType::ModuleChange";
+    case sysrepo::CallbackType::OperGet:
+        return os << "sysrepo::CallbackType::OperGet";
+    case sysrepo::CallbackType::RPCAction:
+        return os << "sysrepo::CallbackType::RPCAction";
+    case sysrepo::CallbackType::Notification:
+        return os << "sysrepo::CallbackType::Notification";
+    }
+
+    return os << "[unknown callback type]";
+}
 }
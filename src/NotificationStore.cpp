@@ -0,0 +1,335 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <sysrepo-cpp/NotificationStore.hpp>
+#include <sysrepo-cpp/utils/exception.hpp>
+#include <unistd.h>
+
+namespace sysrepo {
+namespace {
+constexpr char magic[8] = {'S', 'R', 'N', 'O', 'T', 'I', 'F', '1'};
+constexpr size_t initialSize = 1024 * 1024;
+
+/**
+ * The start of the file. The records follow right after it.
+ */
+struct FileHeader {
+    char magic[8];
+    uint64_t used; // bytes of records, i.e., where the next one goes
+};
+
+/**
+ * A single notification in the file. Followed by `length` bytes of the notification in JSON, padded to 8 bytes.
+ */
+struct RecordHeader {
+    int64_t timestamp; // nanoseconds since the epoch
+    uint32_t length;
+    uint32_t reserved;
+};
+
+size_t recordSize(size_t length)
+{
+    return sizeof(RecordHeader) + (length + 7) / 8 * 8;
+}
+
+[[noreturn]] void throwErrno(const std::string& what, const std::filesystem::path& file)
+{
+    throw std::system_error{errno, std::system_category(), "NotificationStore: " + what + " " + file.string()};
+}
+
+libyang::DataNode treeRoot(libyang::DataNode node)
+{
+    while (auto parent = node.parent()) {
+        node = *parent;
+    }
+    return node;
+}
+}
+
+/**
+ * @brief The shared part of a NotificationStore. Internal use only.
+ */
+struct NotificationStore::State {
+    State(Session session, const std::filesystem::path& file);
+    ~State();
+    State(const State&) = delete;
+    State& operator=(const State&) = delete;
+
+    void map(size_t size);
+    FileHeader* header() const;
+    const RecordHeader* record(size_t offset) const;
+    std::string_view text(size_t offset) const;
+    bool contains(int64_t timestamp, std::string_view text) const;
+    void append(int64_t timestamp, std::string_view text);
+
+    Session session;
+    const std::filesystem::path file;
+    mutable std::mutex mtx;
+    int fd;
+    char* mapping = nullptr;
+    size_t mappedSize = 0;
+    // Sorted by timestamp: the timestamp and the offset of the record (relative to the end of the FileHeader)
+    std::vector<std::pair<int64_t, size_t>> index;
+};
+
+NotificationStore::State::State(Session session, const std::filesystem::path& file)
+    : session(session)
+    , file(file)
+    , fd(::open(file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644))
+{
+    if (fd == -1) {
+        throwErrno("Couldn't open", file);
+    }
+
+    try {
+        if (::flock(fd, LOCK_EX | LOCK_NB) == -1) {
+            if (errno == EWOULDBLOCK) {
+                throw Error{"NotificationStore: " + file.string() + " is in use"};
+            }
+            throwErrno("Couldn't lock", file);
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) == -1) {
+            throwErrno("Couldn't stat", file);
+        }
+
+        if (st.st_size == 0) {
+            if (::ftruncate(fd, initialSize) == -1) {
+                throwErrno("Couldn't resize", file);
+            }
+            map(initialSize);
+            std::memcpy(header()->magic, magic, sizeof(magic));
+            header()->used = 0;
+        } else {
+            map(st.st_size);
+        }
+
+        if (mappedSize < sizeof(FileHeader) || std::memcmp(header()->magic, magic, sizeof(magic)) != 0) {
+            throw Error{"NotificationStore: " + file.string() + " is not a notification store"};
+        }
+        if (header()->used > mappedSize - sizeof(FileHeader)) {
+            throw Error{"NotificationStore: " + file.string() + " is corrupted"};
+        }
+
+        for (size_t offset = 0; offset < header()->used; offset += recordSize(record(offset)->length)) {
+            auto remaining = header()->used - offset;
+            if (remaining < sizeof(RecordHeader) || recordSize(record(offset)->length) > remaining) {
+                throw Error{"NotificationStore: " + file.string() + " is corrupted"};
+            }
+            index.emplace_back(record(offset)->timestamp, offset);
+        }
+        std::stable_sort(index.begin(), index.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    } catch (...) {
+        if (mapping) {
+            ::munmap(mapping, mappedSize);
+        }
+        ::close(fd);
+        throw;
+    }
+}
+
+NotificationStore::State::~State()
+{
+    ::munmap(mapping, mappedSize);
+    ::close(fd);
+}
+
+/**
+ * Maps the first `size` bytes of the file. If that fails, the previous mapping stays in place.
+ */
+void NotificationStore::State::map(size_t size)
+{
+    auto res = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (res == MAP_FAILED) {
+        throwErrno("Couldn't map", file);
+    }
+
+    if (mapping) {
+        ::munmap(mapping, mappedSize);
+    }
+    mapping = static_cast<char*>(res);
+    mappedSize = size;
+}
+
+FileHeader* NotificationStore::State::header() const
+{
+    return reinterpret_cast<FileHeader*>(mapping);
+}
+
+const RecordHeader* NotificationStore::State::record(size_t offset) const
+{
+    return reinterpret_cast<const RecordHeader*>(mapping + sizeof(FileHeader) + offset);
+}
+
+std::string_view NotificationStore::State::text(size_t offset) const
+{
+    return {reinterpret_cast<const char*>(record(offset) + 1), record(offset)->length};
+}
+
+/**
+ * Checks whether exactly this notification is stored already.
+ */
+bool NotificationStore::State::contains(int64_t timestamp, std::string_view text) const
+{
+    auto [begin, end] = std::equal_range(index.begin(), index.end(), std::pair<int64_t, size_t>{timestamp, 0}, [](const auto& a, const auto& b) { return a.first < b.first; });
+    return std::any_of(begin, end, [&](const auto& entry) { return this->text(entry.second) == text; });
+}
+
+void NotificationStore::State::append(int64_t timestamp, std::string_view text)
+{
+    auto offset = header()->used;
+    auto size = recordSize(text.size());
+    if (sizeof(FileHeader) + offset + size > mappedSize) {
+        auto newSize = std::max(mappedSize * 2, sizeof(FileHeader) + offset + size);
+        if (::ftruncate(fd, newSize) == -1) {
+            throwErrno("Couldn't resize", file);
+        }
+        map(newSize);
+    }
+
+    auto rec = reinterpret_cast<RecordHeader*>(mapping + sizeof(FileHeader) + offset);
+    rec->timestamp = timestamp;
+    rec->length = text.size();
+    rec->reserved = 0;
+    std::memcpy(rec + 1, text.data(), text.size());
+    // The record is complete before it becomes part of the file
+    header()->used = offset + size;
+
+    auto pos = std::upper_bound(index.begin(), index.end(), timestamp, [](int64_t ts, const auto& entry) { return ts < entry.first; });
+    index.emplace(pos, timestamp, offset);
+}
+
+/**
+ * Opens the store, creating the file if it does not exist.
+ *
+ * @param session The session whose libyang context is used for reading the notifications back.
+ * @param file Path to the file with the notifications.
+ */
+NotificationStore::NotificationStore(Session session, const std::filesystem::path& file)
+    : m_state(std::make_shared<State>(session, file))
+{
+}
+
+/**
+ * Appends a notification to the store.
+ *
+ * @param notification The notification (or any node in its tree).
+ * @param timestamp Time when the notification was generated.
+ */
+void NotificationStore::append(const libyang::DataNode& notification, const NotificationTimeStamp timestamp)
+{
+    auto text = treeRoot(notification).printStr(libyang::DataFormat::JSON, libyang::PrintFlags::Shrink);
+    std::lock_guard lock{m_state->mtx};
+    m_state->append(timestamp.time_since_epoch().count(), text.value_or(""));
+}
+
+/**
+ * Returns the stored notifications from a time range, ordered by their timestamps.
+ *
+ * @param from Only notifications generated at this time or later.
+ * @param to Only notifications generated at this time or sooner.
+ * @param xpath Only notifications whose tree contains a node matching this XPath, e.g. `/ietf-interfaces:interfaces/interface[name='eth0']/link-down`.
+ */
+std::vector<StoredNotification> NotificationStore::query(const std::optional<NotificationTimeStamp>& from, const std::optional<NotificationTimeStamp>& to, const std::optional<std::string>& xpath) const
+{
+    std::vector<std::pair<int64_t, std::string>> matching;
+    {
+        std::lock_guard lock{m_state->mtx};
+        const auto& index = m_state->index;
+        auto begin = from ? std::lower_bound(index.begin(), index.end(), from->time_since_epoch().count(), [](const auto& entry, int64_t ts) { return entry.first < ts; }) : index.begin();
+        auto end = to ? std::upper_bound(begin, index.end(), to->time_since_epoch().count(), [](int64_t ts, const auto& entry) { return ts < entry.first; }) : index.end();
+        for (auto it = begin; it != end; ++it) {
+            matching.emplace_back(it->first, m_state->text(it->second));
+        }
+    }
+
+    // Parsing is the expensive part, so it happens outside of the lock
+    auto ctx = m_state->session.getContext();
+    std::vector<StoredNotification> res;
+    for (const auto& [timestamp, text] : matching) {
+        auto tree = ctx.parseOp(text, libyang::DataFormat::JSON, libyang::OperationType::NotificationYang).tree;
+        if (!tree || (xpath && tree->findXPath(*xpath).empty())) {
+            continue;
+        }
+        res.push_back({.timestamp = NotificationTimeStamp{std::chrono::nanoseconds{timestamp}}, .tree = *tree});
+    }
+    return res;
+}
+
+/**
+ * Returns the timestamp of the newest stored notification, std::nullopt if the store is empty.
+ */
+std::optional<NotificationTimeStamp> NotificationStore::lastTimestamp() const
+{
+    std::lock_guard lock{m_state->mtx};
+    if (m_state->index.empty()) {
+        return std::nullopt;
+    }
+    return NotificationTimeStamp{std::chrono::nanoseconds{m_state->index.back().first}};
+}
+
+/**
+ * Returns the number of stored notifications.
+ */
+size_t NotificationStore::size() const
+{
+    std::lock_guard lock{m_state->mtx};
+    return m_state->index.size();
+}
+
+/**
+ * Writes the stored notifications to the disk. Without this, they are written whenever the kernel decides to, which
+ * only matters if the whole system goes down.
+ */
+void NotificationStore::flush()
+{
+    std::lock_guard lock{m_state->mtx};
+    if (::msync(m_state->mapping, m_state->mappedSize, MS_SYNC) == -1) {
+        throwErrno("Couldn't sync", m_state->file);
+    }
+}
+
+/**
+ * Subscribes for notifications of a module and stores them as they come.
+ *
+ * If the store is not empty, sysrepo is asked to replay the notifications generated since the newest one in the store
+ * (via the `startTime` of Session::onNotification), so that nothing is missed while the application was not running.
+ * This requires replay support to be enabled for the module. Replayed notifications which are in the store already are
+ * skipped.
+ *
+ * @param session The session to subscribe with.
+ * @param moduleName Name of the module to suscribe to.
+ * @param xpath Optional XPath that filters received notifications.
+ * @param opts Options further changing the behavior of the subscription.
+ * @return The subscription. The store can be destroyed before it.
+ */
+Subscription NotificationStore::subscribe(Session session, const std::string& moduleName, const std::optional<std::string>& xpath, const SubscribeOptions opts)
+{
+    auto startTime = lastTimestamp();
+    return session.onNotification(moduleName, [state = m_state, startTime] (auto, auto, const NotificationType type, const std::optional<libyang::DataNode> tree, const NotificationTimeStamp timestamp) {
+        if ((type != NotificationType::Realtime && type != NotificationType::Replay) || !tree) {
+            return;
+        }
+
+        auto text = treeRoot(*tree).printStr(libyang::DataFormat::JSON, libyang::PrintFlags::Shrink).value_or("");
+        auto ts = timestamp.time_since_epoch().count();
+        std::lock_guard lock{state->mtx};
+        if (type == NotificationType::Replay && startTime && ts <= startTime->time_since_epoch().count() && state->contains(ts, text)) {
+            return;
+        }
+        state->append(ts, text);
+    }, xpath, startTime, std::nullopt, opts);
+}
+}
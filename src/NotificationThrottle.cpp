@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <sysrepo-cpp/NotificationThrottle.hpp>
+#include <sysrepo-cpp/utils/exception.hpp>
+
+namespace sysrepo {
+/**
+ * @param session The session to send the notifications with.
+ * @param policy The limits.
+ * @param summary Creates the summary notifications. If not set, suppressed notifications are just dropped.
+ */
+NotificationThrottle::NotificationThrottle(Session session, const ThrottlePolicy& policy, ThrottleSummaryCb summary)
+    : m_session(session)
+    , m_policy(policy)
+    , m_summary(summary)
+    , m_nextSweep(std::chrono::steady_clock::now() + policy.window)
+{
+    if (policy.burst == 0) {
+        throw Error{"NotificationThrottle: the burst must be at least one"};
+    }
+}
+
+/**
+ * Sends a notification, unless it exceeds the limits. Also sends the summaries of windows which have ended.
+ *
+ * See Session::sendNotification for the description of the parameters.
+ *
+ * @return true if the notification was sent, false if it was suppressed.
+ */
+bool NotificationThrottle::send(libyang::DataNode notification, const Wait wait, std::chrono::milliseconds timeout)
+{
+    auto path = notification.path();
+    std::optional<std::string> content;
+    if (m_policy.suppressDuplicates) {
+        content = notification.printStr(libyang::DataFormat::JSON, libyang::PrintFlags::Shrink).value_or("");
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    Ended ended;
+    bool allowed;
+    {
+        std::lock_guard lock{m_mtx};
+        // Only the window of this path is checked on every send, the others from time to time
+        if (now >= m_nextSweep) {
+            collectEnded(now, false, ended);
+            m_nextSweep = now + m_policy.window;
+        } else if (auto it = m_windows.find(path); it != m_windows.end() && now >= it->second.end) {
+            endWindow(it, ended);
+        }
+
+        auto& window = m_windows.try_emplace(path, Window{.end = now + m_policy.window, .sent = 0, .suppressed = 0, .seen = {}}).first->second;
+        allowed = window.sent < m_policy.burst && (!content || !window.seen.contains(*content));
+        if (allowed) {
+            window.sent++;
+            if (content) {
+                window.seen.insert(std::move(*content));
+            }
+        } else {
+            window.suppressed++;
+            m_suppressed++;
+        }
+    }
+
+    sendSummaries(ended);
+    if (allowed) {
+        std::lock_guard lock{m_sendMtx};
+        m_session.sendNotification(notification, wait, timeout);
+    }
+    return allowed;
+}
+
+/**
+ * Sends the summaries of windows which have ended.
+ *
+ * @param force Also end the windows which are still open, and send their summaries.
+ */
+void NotificationThrottle::flush(const bool force)
+{
+    Ended ended;
+    {
+        std::lock_guard lock{m_mtx};
+        collectEnded(std::chrono::steady_clock::now(), force, ended);
+    }
+    sendSummaries(ended);
+}
+
+/**
+ * Returns the total number of suppressed notifications.
+ */
+uint64_t NotificationThrottle::suppressed() const
+{
+    std::lock_guard lock{m_mtx};
+    return m_suppressed;
+}
+
+void NotificationThrottle::collectEnded(std::chrono::steady_clock::time_point now, bool force, Ended& ended)
+{
+    for (auto it = m_windows.begin(); it != m_windows.end();) {
+        if (!force && now < it->second.end) {
+            ++it;
+        } else {
+            it = endWindow(it, ended);
+        }
+    }
+}
+
+std::map<std::string, NotificationThrottle::Window>::iterator NotificationThrottle::endWindow(std::map<std::string, Window>::iterator window, Ended& ended)
+{
+    if (window->second.suppressed) {
+        ended.emplace_back(window->first, window->second.suppressed);
+    }
+    return m_windows.erase(window);
+}
+
+/**
+ * Sends the summaries of the windows which have ended. Called without m_mtx held, so that the ThrottleSummaryCb can
+ * use the throttle.
+ */
+void NotificationThrottle::sendSummaries(const Ended& ended)
+{
+    if (!m_summary) {
+        return;
+    }
+
+    for (const auto& [path, suppressed] : ended) {
+        if (auto summary = m_summary(path, suppressed)) {
+            std::lock_guard lock{m_sendMtx};
+            m_session.sendNotification(*summary, Wait::No);
+        }
+    }
+}
+}
@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <algorithm>
+#include <sysrepo-cpp/OutputBuilder.hpp>
+#include <sysrepo-cpp/utils/exception.hpp>
+extern "C" {
+#include <sysrepo.h>
+}
+
+namespace sysrepo {
+namespace {
+void throwIfLyError(LY_ERR err, const lysc_node* schema)
+{
+    if (err != LY_SUCCESS) {
+        throw Error{"OutputBuilder: Couldn't create node \"" + std::string{schema->name} + "\" (" + std::to_string(err) + ")"};
+    }
+}
+
+/**
+ * Returns the existing instance of a container, or creates a new one.
+ */
+lyd_node* container(lyd_node* parent, const lysc_node* schema, uint32_t options)
+{
+    lyd_node* node;
+    if (lyd_find_sibling_val(lyd_child(parent), schema, nullptr, 0, &node) == LY_SUCCESS) {
+        return node;
+    }
+    throwIfLyError(lyd_new_inner(parent, schema->module, schema->name, options & LYD_NEW_VAL_OUTPUT, &node), schema);
+    return node;
+}
+
+/**
+ * Creates the node at the end of `steps` below `parent`, along with any missing containers on the way.
+ */
+lyd_node* createAt(lyd_node* parent, std::span<const lysc_node* const> steps, const char* value, uint32_t options)
+{
+    for (auto schema : steps.first(steps.size() - 1)) {
+        if (schema->nodetype != LYS_CONTAINER) {
+            throw Error{"OutputBuilder: Can't create a list instance of \"" + std::string{schema->name} + "\" on the way, create it first"};
+        }
+        parent = container(parent, schema, options);
+    }
+
+    auto schema = steps.back();
+    switch (schema->nodetype) {
+    case LYS_CONTAINER:
+        return container(parent, schema, options);
+    case LYS_LEAF:
+    case LYS_LEAFLIST: {
+        if (!value) {
+            throw Error{"OutputBuilder: A value is required for \"" + std::string{schema->name} + "\""};
+        }
+        lyd_node* node;
+        throwIfLyError(lyd_new_term(parent, schema->module, schema->name, value, options, &node), schema);
+        return node;
+    }
+    default:
+        throw Error{"OutputBuilder: Can't create \"" + std::string{schema->name} + "\" this way"};
+    }
+}
+}
+
+/**
+ * @param session The session, typically the one used for subscribing. Only its libyang context is used.
+ * @param basePath Schema path of the node which all of the fields are relative to, such as the path of the subscription
+ * or of the RPC.
+ * @param nodes Whether to build input or output nodes (the latter for output of RPCs and actions).
+ */
+OutputBuilder::OutputBuilder(Session session, const std::string& basePath, const libyang::InputOutputNodes nodes)
+    : m_basePath(basePath)
+    , m_ctx(sr_session_acquire_context(getRawSession(session)), [session] (const ly_ctx*) { sr_session_release_context(getRawSession(session)); })
+    , m_base(lys_find_path(m_ctx.get(), nullptr, basePath.c_str(), nodes == libyang::InputOutputNodes::Output))
+    , m_options(nodes == libyang::InputOutputNodes::Output ? LYD_NEW_VAL_OUTPUT : 0)
+{
+    if (!m_base) {
+        throw Error{"OutputBuilder: Couldn't find schema node \"" + basePath + "\""};
+    }
+}
+
+/**
+ * Registers a node which this builder will create. Looks the path up in the schema, which is the slow part, so do this
+ * once, upfront.
+ *
+ * @param relativePath Schema path of the node, relative to the base path, such as `interface/statistics/in-octets`.
+ * @return A handle for the other methods. Registering the same path again returns the same handle.
+ */
+OutputBuilder::Field OutputBuilder::field(const std::string& relativePath)
+{
+    if (auto it = m_paths.find(relativePath); it != m_paths.end()) {
+        return Field{it->second};
+    }
+
+    auto path = m_basePath + "/" + relativePath;
+    auto node = lys_find_path(m_ctx.get(), nullptr, path.c_str(), m_options & LYD_NEW_VAL_OUTPUT);
+    if (!node) {
+        throw Error{"OutputBuilder: Couldn't find schema node \"" + path + "\""};
+    }
+
+    std::vector<const lysc_node*> steps;
+    for (; node != m_base; node = node->parent) {
+        if (!node) {
+            throw Error{"OutputBuilder: \"" + path + "\" is not below the base node"};
+        }
+        if (!(node->nodetype & (LYS_CHOICE | LYS_CASE))) {
+            steps.emplace_back(node);
+        }
+    }
+    std::reverse(steps.begin(), steps.end());
+
+    m_fields.emplace_back(std::move(steps));
+    m_paths.emplace(relativePath, m_fields.size() - 1);
+    return Field{m_fields.size() - 1};
+}
+
+/**
+ * Returns the part of the field's steps which follow after the parent node.
+ */
+std::span<const lysc_node* const> OutputBuilder::steps(libyang::DataNode parent, const Field field) const
+{
+    const auto& steps = m_fields.at(field.index);
+    auto schema = libyang::getRawNode(parent)->schema;
+    if (schema == m_base) {
+        return steps;
+    }
+
+    auto it = std::find(steps.begin(), steps.end(), schema);
+    if (it == steps.end() || it + 1 == steps.end()) {
+        throw Error{"OutputBuilder: The parent node is not an ancestor of the field"};
+    }
+    return std::span{it + 1, steps.end()};
+}
+
+/**
+ * Creates a new instance of the base node. Only for a top-level container, e.g. for an OperGetCb which was not given
+ * any parent node.
+ */
+libyang::DataNode OutputBuilder::createBase() const
+{
+    if (m_base->parent || m_base->nodetype != LYS_CONTAINER) {
+        throw Error{"OutputBuilder: The base node is not a top-level container"};
+    }
+
+    lyd_node* node;
+    throwIfLyError(lyd_new_inner(nullptr, m_base->module, m_base->name, false, &node), m_base);
+    return libyang::wrapRawNode(node);
+}
+
+/**
+ * Creates a leaf, a leaf-list instance or a container (unless it exists already) below `parent`. Containers on the way
+ * are created as needed.
+ *
+ * @param parent The base node, or any node on the way to the field.
+ * @param field The node to create.
+ * @param value The value, for a leaf or a leaf-list.
+ * @return The created node. It does not keep the tree alive.
+ */
+libyang::DataNode OutputBuilder::create(libyang::DataNode parent, const Field field, const std::optional<std::string>& value) const
+{
+    auto node = createAt(libyang::getRawNode(parent), steps(parent, field), value ? value->c_str() : nullptr, m_options);
+    return libyang::wrapUnmanagedRawNode(node);
+}
+
+/**
+ * Creates a list instance below `parent`. Containers on the way are created as needed.
+ *
+ * @param parent The base node, or any node on the way to the list.
+ * @param list The list.
+ * @param keys Values of all keys of the list, in the order of the schema.
+ * @return The created list instance. It does not keep the tree alive.
+ */
+libyang::DataNode OutputBuilder::createListInstance(libyang::DataNode parent, const Field list, const std::vector<std::string>& keys) const
+{
+    auto path = steps(parent, list);
+    auto schema = path.back();
+    if (schema->nodetype != LYS_LIST) {
+        throw Error{"OutputBuilder: \"" + std::string{schema->name} + "\" is not a list"};
+    }
+
+    auto node = libyang::getRawNode(parent);
+    for (auto step : path.first(path.size() - 1)) {
+        node = container(node, step, m_options);
+    }
+
+    std::vector<const char*> values;
+    for (const auto& key : keys) {
+        values.emplace_back(key.c_str());
+    }
+    lyd_node* instance;
+    throwIfLyError(lyd_new_list3(node, schema->module, schema->name, values.data(), nullptr, m_options, &instance), schema);
+    return libyang::wrapUnmanagedRawNode(instance);
+}
+
+/**
+ * Creates many instances of a list at once, from values stored by columns.
+ *
+ * Each column holds the values of one node for all of the instances; the i-th instance is built from the i-th value of
+ * each column. There has to be a column for every key of the list, and all columns have to have the same length.
+ * Other columns can be any leaves below the list (possibly in containers, which are created as needed).
+ *
+ * @param parent The base node, or any node on the way to the list.
+ * @param list The list.
+ * @param columns The values of keys and other leaves.
+ */
+void OutputBuilder::createListInstances(libyang::DataNode parent, const Field list, std::span<const Column> columns) const
+{
+    auto path = steps(parent, list);
+    auto schema = path.back();
+    if (schema->nodetype != LYS_LIST) {
+        throw Error{"OutputBuilder: \"" + std::string{schema->name} + "\" is not a list"};
+    }
+
+    std::vector<const lysc_node*> keys;
+    for (auto key = lysc_node_child(schema); key && lysc_is_key(key); key = key->next) {
+        keys.emplace_back(key);
+    }
+
+    const auto& listSteps = m_fields.at(list.index);
+    auto rows = columns.empty() ? 0 : columns.front().values.size();
+    std::vector<const std::span<const std::string>*> keyColumns(keys.size(), nullptr);
+    std::vector<std::pair<std::span<const lysc_node* const>, const std::span<const std::string>*>> otherColumns;
+    for (const auto& column : columns) {
+        const auto& columnSteps = m_fields.at(column.field.index);
+        if (columnSteps.size() <= listSteps.size() || !std::equal(listSteps.begin(), listSteps.end(), columnSteps.begin())) {
+            throw Error{"OutputBuilder: A column is not below the list"};
+        }
+        if (column.values.size() != rows) {
+            throw Error{"OutputBuilder: The columns have different lengths"};
+        }
+
+        auto relative = std::span{columnSteps}.subspan(listSteps.size());
+        if (auto key = std::find(keys.begin(), keys.end(), relative.front()); relative.size() == 1 && key != keys.end()) {
+            keyColumns[key - keys.begin()] = &column.values;
+        } else {
+            otherColumns.emplace_back(relative, &column.values);
+        }
+    }
+    if (std::find(keyColumns.begin(), keyColumns.end(), nullptr) != keyColumns.end()) {
+        throw Error{"OutputBuilder: A column for a key of \"" + std::string{schema->name} + "\" is missing"};
+    }
+
+    auto node = libyang::getRawNode(parent);
+    for (auto step : path.first(path.size() - 1)) {
+        node = container(node, step, m_options);
+    }
+
+    std::vector<const char*> keyValues(keys.size());
+    for (size_t row = 0; row < rows; ++row) {
+        for (size_t i = 0; i < keys.size(); ++i) {
+            keyValues[i] = (*keyColumns[i])[row].c_str();
+        }
+        lyd_node* instance;
+        throwIfLyError(lyd_new_list3(node, schema->module, schema->name, keyValues.data(), nullptr, m_options, &instance), schema);
+        for (const auto& [steps, values] : otherColumns) {
+            createAt(instance, steps, (*values)[row].c_str(), m_options);
+        }
+    }
+}
+}
@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <optional>
+#include <string_view>
+#include <sysrepo-cpp/RequestXPath.hpp>
+
+using namespace std::string_view_literals;
+
+namespace sysrepo {
+namespace {
+std::string_view trim(std::string_view str)
+{
+    auto begin = str.find_first_not_of(" \t\n");
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    return str.substr(begin, str.find_last_not_of(" \t\n") - begin + 1);
+}
+
+std::string_view withoutPrefix(std::string_view name)
+{
+    auto colon = name.find(':');
+    return colon == std::string_view::npos ? name : name.substr(colon + 1);
+}
+
+/**
+ * Finds `needle` in `str`, skipping over quoted literals and (when `skipPredicates` is set) bracketed predicates.
+ */
+size_t findUnquoted(std::string_view str, std::string_view needle, size_t pos = 0, bool skipPredicates = false)
+{
+    std::optional<char> quote;
+    int depth = 0;
+    for (auto i = pos; i < str.size(); ++i) {
+        if (quote) {
+            if (str[i] == *quote) {
+                quote.reset();
+            }
+        } else if (str[i] == '\'' || str[i] == '"') {
+            quote = str[i];
+        } else if (skipPredicates && str[i] == '[') {
+            ++depth;
+        } else if (skipPredicates && str[i] == ']') {
+            --depth;
+        } else if (depth == 0 && str.substr(i).starts_with(needle)) {
+            return i;
+        }
+    }
+    return std::string_view::npos;
+}
+
+bool isNameChar(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-' || c == '.' || c == ':';
+}
+
+/**
+ * Finds the operator `word` (such as `and`) in `str`, outside of quoted literals. Unlike a name, the operator does not
+ * need any whitespace around it when next to a literal or a parenthesis (e.g., `name='a'and type='b'`).
+ */
+size_t findOperator(std::string_view str, std::string_view word, size_t pos = 0)
+{
+    for (auto i = findUnquoted(str, word, pos); i != std::string_view::npos; i = findUnquoted(str, word, i + 1)) {
+        auto after = i + word.size();
+        if ((i == 0 || !isNameChar(str[i - 1])) && (after == str.size() || !isNameChar(str[after]))) {
+            return i;
+        }
+    }
+    return std::string_view::npos;
+}
+
+std::optional<double> toNumber(std::string_view str)
+{
+    double res;
+    auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), res);
+    if (ec != std::errc{} || ptr != str.data() + str.size()) {
+        return std::nullopt;
+    }
+    return res;
+}
+
+/**
+ * Parses a single `key <op> literal` term of a predicate.
+ */
+std::optional<KeyConstraint> parseTerm(std::string_view term)
+{
+    // the two-character operators have to be tried first
+    static const std::array<std::pair<std::string_view, KeyConstraint::Operator>, 6> operators{{
+        {"!="sv, KeyConstraint::Operator::NotEqual},
+        {"<="sv, KeyConstraint::Operator::LessOrEqual},
+        {">="sv, KeyConstraint::Operator::GreaterOrEqual},
+        {"="sv, KeyConstraint::Operator::Equal},
+        {"<"sv, KeyConstraint::Operator::Less},
+        {">"sv, KeyConstraint::Operator::Greater},
+    }};
+
+    for (const auto& [symbol, op] : operators) {
+        auto pos = findUnquoted(term, symbol);
+        if (pos == std::string_view::npos) {
+            continue;
+        }
+
+        auto key = withoutPrefix(trim(term.substr(0, pos)));
+        auto value = trim(term.substr(pos + symbol.size()));
+        if (value.size() >= 2 && (value.front() == '\'' || value.front() == '"') && value.back() == value.front()) {
+            value = value.substr(1, value.size() - 2);
+        } else if (!toNumber(value)) {
+            // a path or a function call, not a literal
+            return std::nullopt;
+        }
+        return KeyConstraint{std::string{key}, op, std::string{value}};
+    }
+
+    return std::nullopt;
+}
+
+/**
+ * Parses the contents of a predicate into `step.constraints`. Returns false if (some of) the predicate was ignored.
+ */
+bool parsePredicate(std::string_view predicate, RequestedStep& step)
+{
+    if (findOperator(predicate, "or") != std::string_view::npos || findUnquoted(predicate, "(") != std::string_view::npos) {
+        return false;
+    }
+
+    std::vector<std::string> allowed;
+    if (step.node.nodeType() == libyang::NodeType::List) {
+        for (const auto& key : step.node.asList().keys()) {
+            allowed.emplace_back(key.name());
+        }
+    } else if (step.node.nodeType() == libyang::NodeType::Leaflist) {
+        allowed.emplace_back(".");
+    }
+
+    bool exact = true;
+    size_t pos = 0;
+    while (pos <= predicate.size()) {
+        auto end = std::min(findOperator(predicate, "and", pos), predicate.size());
+        auto constraint = parseTerm(predicate.substr(pos, end - pos));
+        // leaving out a term of a conjunction only makes the result broader
+        if (constraint && std::find(allowed.begin(), allowed.end(), constraint->key) != allowed.end()) {
+            step.constraints.emplace_back(std::move(*constraint));
+        } else {
+            exact = false;
+        }
+        pos = end + "and"sv.size();
+    }
+    return exact;
+}
+
+bool satisfies(const std::string& actual, const KeyConstraint& constraint)
+{
+    auto actualNumber = toNumber(actual);
+    auto expectedNumber = toNumber(constraint.value);
+    auto cmp = actualNumber && expectedNumber ? (*actualNumber <=> *expectedNumber) : (actual <=> constraint.value);
+
+    switch (constraint.op) {
+    case KeyConstraint::Operator::Equal:
+        return cmp == 0;
+    case KeyConstraint::Operator::NotEqual:
+        return cmp != 0;
+    case KeyConstraint::Operator::Less:
+        return cmp < 0;
+    case KeyConstraint::Operator::LessOrEqual:
+        return cmp <= 0;
+    case KeyConstraint::Operator::Greater:
+        return cmp > 0;
+    case KeyConstraint::Operator::GreaterOrEqual:
+        return cmp >= 0;
+    }
+
+    __builtin_unreachable();
+}
+}
+
+/**
+ * Parses the `requestXPath` of an operational data request (see OperGetCb), so that the provider can generate only
+ * the requested data instead of all of it.
+ *
+ * Only a simple absolute path is understood, such as `/ietf-interfaces:interfaces/interface[name='eth0']/statistics`,
+ * with predicates which compare list keys (or leaf-list values) with literals, optionally joined with `and`. Anything
+ * else (wildcards, the descendant axis, unions, functions, ...) ends the path or is ignored, which makes the result
+ * broader, as indicated by RequestedData::exact.
+ *
+ * @param ctx The context with the schema of the requested data, usually from Session::getContext.
+ * @param requestXPath The request XPath as passed to the callback.
+ */
+RequestedData parseRequestXPath(const libyang::Context& ctx, const std::string& requestXPath)
+{
+    std::string_view xpath = trim(requestXPath);
+    RequestedData res{.steps = {}, .exact = false};
+
+    if (!xpath.starts_with('/') || findUnquoted(xpath, "|", 0, true) != std::string_view::npos) {
+        return res;
+    }
+
+    std::string schemaPath;
+    size_t pos = 0;
+    while (pos < xpath.size()) {
+        if (xpath[pos] != '/' || xpath.substr(pos).starts_with("//")) {
+            return res;
+        }
+        ++pos;
+
+        auto end = std::min(xpath.find_first_of("/[ ", pos), xpath.size());
+        auto name = xpath.substr(pos, end - pos);
+        pos = end;
+        if (name == ".") {
+            continue;
+        }
+        if (name == "..") {
+            // not worth tracking, just ask for everything
+            res.steps.clear();
+            return res;
+        }
+        if (name.empty() || name.find_first_of("*()@") != std::string_view::npos) {
+            return res;
+        }
+
+        schemaPath += '/';
+        schemaPath += name;
+        std::optional<libyang::SchemaNode> node;
+        try {
+            node = ctx.findPath(schemaPath);
+        } catch (libyang::Error&) {
+            return res;
+        }
+
+        RequestedStep step{.node = *node, .constraints = {}};
+        bool stepExact = true;
+        while (pos < xpath.size() && xpath[pos] == '[') {
+            auto close = findUnquoted(xpath, "]", pos + 1);
+            if (close == std::string_view::npos) {
+                res.steps.clear();
+                return res;
+            }
+            stepExact = parsePredicate(trim(xpath.substr(pos + 1, close - pos - 1)), step) && stepExact;
+            pos = close + 1;
+        }
+
+        res.steps.emplace_back(std::move(step));
+        if (!stepExact) {
+            return res;
+        }
+    }
+
+    res.exact = true;
+    return res;
+}
+
+/**
+ * Returns true if (some instances of) the node are requested: either it is on the path to the requested node, or it is
+ * the requested node or below it.
+ */
+bool RequestedData::isRequested(const libyang::SchemaNode& node) const
+{
+    if (steps.empty()) {
+        return true;
+    }
+
+    const auto& requested = steps.back().node;
+    for (std::optional<libyang::SchemaNode> it = requested; it; it = it->parent()) {
+        if (*it == node) {
+            return true;
+        }
+    }
+    for (std::optional<libyang::SchemaNode> it = node; it; it = it->parent()) {
+        if (*it == requested) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Returns true if the list instance with these keys is requested.
+ *
+ * @param list The schema node of the list (or of the leaf-list).
+ * @param keys Names and values of the keys of the instance (for a leaf-list, `.` and its value). Keys which are
+ * missing here are not checked.
+ */
+bool RequestedData::isRequested(const libyang::SchemaNode& list, const std::vector<std::pair<std::string, std::string>>& keys) const
+{
+    if (!isRequested(list)) {
+        return false;
+    }
+
+    for (const auto& step : steps) {
+        if (!(step.node == list)) {
+            continue;
+        }
+        for (const auto& constraint : step.constraints) {
+            auto key = std::find_if(keys.begin(), keys.end(), [&](const auto& key) { return key.first == constraint.key; });
+            if (key != keys.end() && !satisfies(key->second, constraint)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+}
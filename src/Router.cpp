@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <mutex>
+#include <sysrepo-cpp/Router.hpp>
+#include <sysrepo-cpp/utils/exception.hpp>
+#include <unordered_map>
+extern "C" {
+#include <sysrepo.h>
+}
+
+namespace sysrepo {
+namespace {
+std::shared_ptr<const ly_ctx> acquireContext(Session session)
+{
+    return {sr_session_acquire_context(getRawSession(session)), [session] (const ly_ctx*) { sr_session_release_context(getRawSession(session)); }};
+}
+
+/**
+ * Finds the node of the notification in its tree, which starts at the top-level node.
+ */
+std::optional<libyang::DataNode> findNotification(const libyang::DataNode& tree)
+{
+    for (const auto& node : tree.childrenDfs()) {
+        auto schema = libyang::getRawNode(node)->schema;
+        if (schema && schema->nodetype == LYS_NOTIF) {
+            return node;
+        }
+    }
+    return std::nullopt;
+}
+
+/**
+ * Collects the keys of the list instances above an action, starting with the outermost list.
+ */
+std::vector<libyang::DataNodeTerm> parentKeys(const libyang::DataNode& operation)
+{
+    std::vector<const lyd_node*> lists;
+    for (auto node = lyd_parent(libyang::getRawNode(operation)); node; node = lyd_parent(node)) {
+        if (node->schema->nodetype == LYS_LIST) {
+            lists.emplace_back(node);
+        }
+    }
+
+    std::vector<libyang::DataNodeTerm> keys;
+    for (auto list = lists.rbegin(); list != lists.rend(); ++list) {
+        // The keys are always the first children of a list instance
+        for (auto key = lyd_child(*list); key && lysc_is_key(key->schema); key = key->next) {
+            keys.emplace_back(libyang::wrapUnmanagedRawNode(key).asTerm());
+        }
+    }
+    return keys;
+}
+}
+
+/**
+ * @brief The shared part of a NotificationRouter. Internal use only.
+ */
+struct NotificationRouter::State {
+    std::shared_ptr<const ly_ctx> ctx;
+    std::mutex mtx;
+    std::unordered_map<const lysc_node*, RoutedNotifCb> handlers;
+};
+
+/**
+ * Creates a router with no handlers.
+ *
+ * @param session The session which will be used for subscribing.
+ * @param handler Optional exception handler that will be called when an exception occurs in a handler.
+ * @param callbacks Custom event loop callbacks that are called when the subscription context is created and destroyed.
+ * If this argument is used, all handlers must be registered with SubscribeOptions::NoThread.
+ *
+ * Acquires the libyang context of the session until the router is destroyed, see NotificationRouter.
+ */
+NotificationRouter::NotificationRouter(Session session, ExceptionHandler handler, const std::optional<FDHandling>& callbacks)
+    : m_session(session)
+    , m_exceptionHandler(handler)
+    , m_customEventLoopCbs(callbacks)
+    , m_state(std::make_shared<State>(acquireContext(session)))
+{
+}
+
+/**
+ * Registers a handler of a notification. Subscribes to the module of the notification, unless the router has
+ * subscribed to it already.
+ *
+ * Wraps `sr_notif_subscribe_tree`.
+ *
+ * @param notificationPath Schema path of the notification, e.g. `/ietf-interfaces:interfaces/interface/link-down`.
+ * @param cb The handler. Replaces the previous handler of the same notification, if any.
+ * @param opts Options of the subscription to the module. Only used when the module is subscribed to.
+ */
+void NotificationRouter::on(const std::string& notificationPath, RoutedNotifCb cb, const SubscribeOptions opts)
+{
+    if (!cb) {
+        throw Error{"NotificationRouter: empty handler for \"" + notificationPath + "\""};
+    }
+
+    auto schema = lys_find_path(m_state->ctx.get(), nullptr, notificationPath.c_str(), false);
+    if (!schema || schema->nodetype != LYS_NOTIF) {
+        throw Error{"NotificationRouter: \"" + notificationPath + "\" is not a notification"};
+    }
+
+    bool inserted;
+    {
+        std::lock_guard lock{m_state->mtx};
+        inserted = m_state->handlers.insert_or_assign(schema, cb).second;
+    }
+
+    std::string moduleName{schema->module->name};
+    if (m_subscribedModules.contains(moduleName)) {
+        return;
+    }
+
+    auto dispatch = [state = m_state] (Session session, uint32_t, const NotificationType type, const std::optional<libyang::DataNode> tree, const NotificationTimeStamp timestamp) {
+        if (!tree) {
+            return;
+        }
+        auto notification = findNotification(*tree);
+        if (!notification) {
+            return;
+        }
+
+        RoutedNotifCb handler;
+        {
+            std::lock_guard lock{state->mtx};
+            auto it = state->handlers.find(libyang::getRawNode(*notification)->schema);
+            if (it == state->handlers.end()) {
+                return;
+            }
+            handler = it->second;
+        }
+        handler(session, type, *notification, timestamp);
+    };
+
+    try {
+        if (m_sub) {
+            m_sub->onNotification(moduleName, dispatch, std::nullopt, std::nullopt, std::nullopt, opts);
+        } else {
+            m_sub = m_session.onNotification(moduleName, dispatch, std::nullopt, std::nullopt, std::nullopt, opts, m_exceptionHandler, m_customEventLoopCbs);
+        }
+    } catch (...) {
+        if (inserted) {
+            std::lock_guard lock{m_state->mtx};
+            m_state->handlers.erase(schema);
+        }
+        throw;
+    }
+    m_subscribedModules.insert(moduleName);
+}
+
+/**
+ * @brief The shared part of an RpcRouter. Internal use only.
+ */
+struct RpcRouter::State {
+    std::shared_ptr<const ly_ctx> ctx;
+    std::mutex mtx;
+    std::unordered_map<const lysc_node*, RoutedRpcCb> handlers;
+};
+
+/**
+ * Creates a router with no handlers.
+ *
+ * @param session The session which will be used for subscribing.
+ * @param handler Optional exception handler that will be called when an exception occurs in a handler.
+ * @param callbacks Custom event loop callbacks that are called when the subscription context is created and destroyed.
+ * If this argument is used, all handlers must be registered with SubscribeOptions::NoThread.
+ *
+ * Acquires the libyang context of the session until the router is destroyed, see RpcRouter.
+ */
+RpcRouter::RpcRouter(Session session, ExceptionHandler handler, const std::optional<FDHandling>& callbacks)
+    : m_session(session)
+    , m_exceptionHandler(handler)
+    , m_customEventLoopCbs(callbacks)
+    , m_state(std::make_shared<State>(acquireContext(session)))
+{
+}
+
+/**
+ * Registers a handler of an RPC or an action.
+ *
+ * Wraps `sr_rpc_subscribe_tree`.
+ *
+ * @param operationPath Schema path of the RPC/action, e.g. `/ietf-interfaces:interfaces/interface/reset`.
+ * @param cb The handler. Replaces the previous handler of the same RPC/action, if any.
+ * @param priority Optional priority in which the handlers of the same RPC/action are called. Only used when the
+ * RPC/action is subscribed to, i.e., the first time a handler is registered for it.
+ * @param opts Options of the subscription. Only used when the RPC/action is subscribed to.
+ */
+void RpcRouter::on(const std::string& operationPath, RoutedRpcCb cb, uint32_t priority, const SubscribeOptions opts)
+{
+    if (!cb) {
+        throw Error{"RpcRouter: empty handler for \"" + operationPath + "\""};
+    }
+
+    auto schema = lys_find_path(m_state->ctx.get(), nullptr, operationPath.c_str(), false);
+    if (!schema || !(schema->nodetype & (LYS_RPC | LYS_ACTION))) {
+        throw Error{"RpcRouter: \"" + operationPath + "\" is not an RPC or an action"};
+    }
+
+    {
+        std::lock_guard lock{m_state->mtx};
+        auto [it, inserted] = m_state->handlers.insert_or_assign(schema, cb);
+        if (!inserted) {
+            return;
+        }
+    }
+
+    auto dispatch = [state = m_state] (Session session, uint32_t, const std::string&, const libyang::DataNode input, const Event event, uint32_t, libyang::DataNode output) {
+        RoutedRpcCb handler;
+        {
+            std::lock_guard lock{state->mtx};
+            auto it = state->handlers.find(libyang::getRawNode(input)->schema);
+            if (it == state->handlers.end()) {
+                return ErrorCode::OperationFailed;
+            }
+            handler = it->second;
+        }
+        return handler(session, input, parentKeys(input), event, output);
+    };
+
+    try {
+        if (m_sub) {
+            m_sub->onRPCAction(operationPath, dispatch, priority, opts);
+        } else {
+            m_sub = m_session.onRPCAction(operationPath, dispatch, priority, opts, m_exceptionHandler, m_customEventLoopCbs);
+        }
+    } catch (...) {
+        std::lock_guard lock{m_state->mtx};
+        m_state->handlers.erase(schema);
+        throw;
+    }
+}
+}
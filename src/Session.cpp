@@ -14,11 +14,15 @@ extern "C" {
 }
 #include <libyang-cpp/Context.hpp>
 #include <sysrepo-cpp/Connection.hpp>
+#include <set>
 #include <span>
 #include <sysrepo-cpp/Subscription.hpp>
 #include <utility>
 #include "utils/enum.hpp"
 #include "utils/exception.hpp"
+#include "utils/probes.hpp"
+#include "utils/stats.hpp"
+#include "utils/tracing.hpp"
 #include "utils/utils.hpp"
 
 using namespace std::string_literals;
@@ -81,7 +85,11 @@ void Session::switchDatastore(const Datastore ds) const
  */
 void Session::setItem(const std::string& path, const std::optional<std::string>& value, const EditOptions opts)
 {
+    Span span{"Session::setItem", m_sess.get(), path};
+    SYSREPO_CPP_PROBE(set_item__entry, sr_session_get_id(m_sess.get()), path.c_str());
     auto res = sr_set_item_str(m_sess.get(), path.c_str(), value ? value->c_str() : nullptr, nullptr, toEditOptions(opts));
+    SYSREPO_CPP_PROBE(set_item__return, sr_session_get_id(m_sess.get()), path.c_str(), res);
+    span.setResult(res);
 
     throwIfError(res, "Session::setItem: Couldn't set '"s + path + "'"s + (value ? (" to '"s + *value + "'") : ""), m_sess.get());
 }
@@ -168,8 +176,10 @@ libyang::DataNode wrapSrData(std::shared_ptr<sr_session_ctx_s> sess, sr_data_t*
 
     // Use wrapRawNode, not wrapUnmanagedRawNode because we want to let the C++ wrapper manage memory.
     // Note: We're capturing the session inside the lambda.
+    libraryCounters().outstandingData.fetch_add(1, std::memory_order_relaxed);
     return libyang::wrapRawNode(tree, std::shared_ptr<sr_data_t>(data, [extend_session_lifetime = sess] (sr_data_t* data) {
         sr_release_data(data);
+        libraryCounters().outstandingData.fetch_sub(1, std::memory_order_relaxed);
     }));
 }
 }
@@ -195,7 +205,11 @@ libyang::DataNode wrapSrData(std::shared_ptr<sr_session_ctx_s> sess, sr_data_t*
 std::optional<libyang::DataNode> Session::getData(const std::string& path, int maxDepth, const GetOptions opts, std::chrono::milliseconds timeout) const
 {
     sr_data_t* data;
+    Span span{"Session::getData", m_sess.get(), path};
+    SYSREPO_CPP_PROBE(get_data__entry, sr_session_get_id(m_sess.get()), path.c_str());
     auto res = sr_get_data(m_sess.get(), path.c_str(), maxDepth, timeout.count(), toGetOptions(opts), &data);
+    SYSREPO_CPP_PROBE(get_data__return, sr_session_get_id(m_sess.get()), path.c_str(), res);
+    span.setResult(res);
 
     throwIfError(res, "Session::getData: Couldn't get '"s + path + "'", m_sess.get());
 
@@ -257,7 +271,11 @@ std::optional<const libyang::DataNode> Session::getPendingChanges() const
  */
 void Session::applyChanges(std::chrono::milliseconds timeout)
 {
+    Span span{"Session::applyChanges", m_sess.get(), std::nullopt};
+    SYSREPO_CPP_PROBE(apply_changes__entry, sr_session_get_id(m_sess.get()));
     auto res = sr_apply_changes(m_sess.get(), timeout.count());
+    SYSREPO_CPP_PROBE(apply_changes__return, sr_session_get_id(m_sess.get()), res);
+    span.setResult(res);
 
     throwIfError(res, "Session::applyChanges: Couldn't apply changes", m_sess.get());
 }
@@ -302,7 +320,11 @@ void Session::copyConfig(const Datastore source, const std::optional<std::string
 libyang::DataNode Session::sendRPC(libyang::DataNode input, std::chrono::milliseconds timeout)
 {
     sr_data_t* output;
+    Span span{"Session::sendRPC", m_sess.get(), LYD_NAME(libyang::getRawNode(input))};
+    SYSREPO_CPP_PROBE(send_rpc__entry, sr_session_get_id(m_sess.get()), LYD_NAME(libyang::getRawNode(input)));
     auto res = sr_rpc_send_tree(m_sess.get(), libyang::getRawNode(input), timeout.count(), &output);
+    SYSREPO_CPP_PROBE(send_rpc__return, sr_session_get_id(m_sess.get()), LYD_NAME(libyang::getRawNode(input)), res);
+    span.setResult(res);
     throwIfError(res, "Couldn't send RPC", m_sess.get());
 
     assert(output); // TODO: sysrepo always gives the RPC node? (even when it has not output or output nodes?)
@@ -320,10 +342,56 @@ libyang::DataNode Session::sendRPC(libyang::DataNode input, std::chrono::millise
  */
 void Session::sendNotification(libyang::DataNode notification, const Wait wait, std::chrono::milliseconds timeout)
 {
+    Span span{"Session::sendNotification", m_sess.get(), LYD_NAME(libyang::getRawNode(notification))};
+    SYSREPO_CPP_PROBE(send_notification__entry, sr_session_get_id(m_sess.get()), LYD_NAME(libyang::getRawNode(notification)));
     auto res = sr_notif_send_tree(m_sess.get(), libyang::getRawNode(notification), timeout.count(), wait == Wait::Yes ? 1 : 0);
+    SYSREPO_CPP_PROBE(send_notification__return, sr_session_get_id(m_sess.get()), LYD_NAME(libyang::getRawNode(notification)), res);
+    span.setResult(res);
     throwIfError(res, "Couldn't send notification", m_sess.get());
 }
 
+/**
+ * Send a batch of notifications.
+ *
+ * The notifications are sent one after another without waiting for the notification callbacks in between, so that
+ * the round trips to the subscribers overlap. With Wait::Yes, only the last notification of each module waits for
+ * its callbacks; since the notifications of a module are delivered in order, this means waiting for the whole batch.
+ * A notification which fails to be sent does not stop the rest of the batch.
+ *
+ * Wraps `sr_notif_send_tree`.
+ *
+ * @param notifications Libyang trees representing the notifications.
+ * @param wait Specifies whether to wait until all (if any) notification callbacks were called.
+ * @param timeout Optional timeout. Only meaningful if we're waiting for the notification callbacks.
+ * @return The notifications which could not be sent.
+ */
+std::vector<NotificationFailure> Session::sendNotifications(std::span<const libyang::DataNode> notifications, const Wait wait, std::chrono::milliseconds timeout)
+{
+    std::vector<bool> waitFor(notifications.size(), false);
+    if (wait == Wait::Yes) {
+        std::set<const lys_module*> seen;
+        for (size_t i = notifications.size(); i-- > 0;) {
+            waitFor[i] = seen.insert(libyang::getRawNode(notifications[i])->schema->module).second;
+        }
+    }
+
+    auto target = std::to_string(notifications.size()) + " notifications";
+    Span span{"Session::sendNotifications", m_sess.get(), target};
+    std::vector<NotificationFailure> failures;
+    for (size_t i = 0; i < notifications.size(); ++i) {
+        auto raw = libyang::getRawNode(notifications[i]);
+        SYSREPO_CPP_PROBE(send_notification__entry, sr_session_get_id(m_sess.get()), LYD_NAME(raw));
+        auto res = sr_notif_send_tree(m_sess.get(), raw, timeout.count(), waitFor[i] ? 1 : 0);
+        SYSREPO_CPP_PROBE(send_notification__return, sr_session_get_id(m_sess.get()), LYD_NAME(raw), res);
+        if (res != SR_ERR_OK) {
+            failures.push_back({.index = i, .code = static_cast<ErrorCode>(res), .errorMessage = errorMessage(res, "Couldn't send notification", m_sess.get())});
+        }
+    }
+    span.setResult(failures.empty() ? SR_ERR_OK : static_cast<int>(failures.front().code));
+
+    return failures;
+}
+
 
 /**
  * Replace datastore's content with the provided data
@@ -379,6 +447,29 @@ Subscription Session::onModuleChange(
     return sub;
 }
 
+/**
+ * Subscribe for changes made in the specified module, with the changes processed asynchronously.
+ *
+ * Wraps `sr_module_change_subscribe`. See Subscription::onModuleChangeAsync and Session::onModuleChange for details.
+ * Requires a custom event loop, i.e., `callbacks` and SubscribeOptions::NoThread.
+ *
+ * @return The Subscription handle.
+ */
+Subscription Session::onModuleChangeAsync(
+        const std::string& moduleName,
+        AsyncModuleChangeCb cb,
+        const std::optional<std::string>& xpath,
+        uint32_t priority,
+        const SubscribeOptions opts,
+        ExceptionHandler handler,
+        const std::optional<FDHandling>& callbacks)
+{
+    checkNoThreadFlag(opts, callbacks);
+    auto sub = Subscription{m_sess, handler, callbacks};
+    sub.onModuleChangeAsync(moduleName, cb, xpath, priority, opts);
+    return sub;
+}
+
 /**
  * Subscribe for providing operational data at the given xpath.
  *
@@ -694,6 +785,76 @@ void Session::setOriginatorName(const std::string& originatorName)
     throwIfError(res, "Couldn't switch datastore", m_sess.get());
 }
 
+/**
+ * Appends a chunk of event originator data. The data are passed along with all events caused by this session, the
+ * originator name has to be set before.
+ *
+ * Wraps `sr_session_push_orig_data`.
+ * @param data The data to append. They do not have to be printable.
+ */
+void Session::pushOriginatorData(const std::string& data)
+{
+    auto res = sr_session_push_orig_data(m_sess.get(), data.size(), data.data());
+    throwIfError(res, "Couldn't push originator data", m_sess.get());
+}
+
+/**
+ * Gets a chunk of event originator data.
+ *
+ * Wraps `sr_session_get_orig_data`.
+ * @param idx Index of the chunk.
+ * @return The data, or std::nullopt if there's no chunk with such index.
+ */
+std::optional<std::string> Session::getOriginatorData(uint32_t idx) const
+{
+    uint32_t size;
+    const void* data;
+    auto res = sr_session_get_orig_data(m_sess.get(), idx, &size, &data);
+    if (res == SR_ERR_NOT_FOUND) {
+        return std::nullopt;
+    }
+    throwIfError(res, "Couldn't get originator data", m_sess.get());
+
+    return std::string{static_cast<const char*>(data), size};
+}
+
+/**
+ * @brief Sets the trace ID which is reported to the Tracer and propagated to other processes.
+ *
+ * The trace ID is stored as a chunk of the originator data, so the originator name has to be set before. If the
+ * session already carries a trace ID, it is replaced. Other chunks of the originator data are preserved.
+ *
+ * Wraps `sr_session_del_orig_data` and `sr_session_push_orig_data`.
+ * @param traceId The new trace ID.
+ */
+void Session::setTraceId(const std::string& traceId)
+{
+    std::vector<std::string> otherChunks;
+    for (uint32_t idx = 0; auto chunk = getOriginatorData(idx); ++idx) {
+        if (!chunk->starts_with(traceIdPrefix)) {
+            otherChunks.emplace_back(std::move(*chunk));
+        }
+    }
+
+    auto res = sr_session_del_orig_data(m_sess.get());
+    throwIfError(res, "Couldn't delete originator data", m_sess.get());
+    for (const auto& chunk : otherChunks) {
+        pushOriginatorData(chunk);
+    }
+    pushOriginatorData(std::string{traceIdPrefix} + traceId);
+}
+
+/**
+ * @brief Returns the trace ID of this session.
+ *
+ * In a callback, this is the trace ID set by the originator of the event.
+ * @return The trace ID, or std::nullopt if there's none.
+ */
+std::optional<std::string> Session::getTraceId() const
+{
+    return sysrepo::getTraceId(m_sess.get());
+}
+
 /**
  * Returns the connection this session was created on.
  */
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <sstream>
+#include <sysrepo-cpp/Statistics.hpp>
+#include <unistd.h>
+#include "utils/stats.hpp"
+
+using namespace std::string_literals;
+namespace sysrepo {
+namespace {
+const auto statsModule = "sysrepo-cpp-stats";
+
+const char* yangName(const CallbackType type)
+{
+    switch (type) {
+    case CallbackType::ModuleChange:
+        return "module-change";
+    case CallbackType::OperGet:
+        return "oper-get";
+    case CallbackType::RPCAction:
+        return "rpc-action";
+    case CallbackType::Notification:
+        return "notification";
+    }
+
+    __builtin_unreachable();
+}
+
+const char* yangName(const Event event)
+{
+    switch (event) {
+    case Event::Update:
+        return "update";
+    case Event::Change:
+        return "change";
+    case Event::Done:
+        return "done";
+    case Event::Abort:
+        return "abort";
+    case Event::Enabled:
+        return "enabled";
+    case Event::RPC:
+        return "rpc";
+    }
+
+    __builtin_unreachable();
+}
+
+std::string errorCodeKey(const ErrorCode code)
+{
+    std::ostringstream oss;
+    oss << code;
+    return oss.str();
+}
+
+void fillInvocationStats(libyang::DataNode parent, const InvocationStats& stats)
+{
+    parent.newPath("invocations", std::to_string(stats.invocations));
+    parent.newPath("exceptions", std::to_string(stats.exceptions));
+    for (const auto& [code, count] : stats.errorCodes) {
+        parent.newPath("return-code[code='" + errorCodeKey(code) + "']/count", std::to_string(count));
+    }
+    parent.newPath("total-time", std::to_string(stats.latency.total.count()));
+    parent.newPath("max-time", std::to_string(stats.latency.max.count()));
+    for (size_t i = 0; i < stats.latency.buckets.size(); ++i) {
+        if (stats.latency.buckets[i]) {
+            // the last bucket also counts everything slower, so it has no upper bound
+            auto upperBound = i + 1 == stats.latency.buckets.size() ? std::string{"+inf"} : std::to_string(uint64_t{1} << i);
+            parent.newPath("latency-bucket[upper-bound='" + upperBound + "']/count", std::to_string(stats.latency.buckets[i]));
+        }
+    }
+}
+}
+
+/**
+ * Returns a snapshot of the runtime statistics of the whole library within this process.
+ */
+LibraryStats libraryStats()
+{
+    auto& lib = libraryCounters();
+    LibraryStats res{
+        .sessionsCreated = lib.sessionsCreated.load(std::memory_order_relaxed),
+        .subscriptionsAlive = lib.subscriptionsAlive.load(std::memory_order_relaxed),
+        .outstandingData = lib.outstandingData.load(std::memory_order_relaxed),
+        .errors = {},
+        .callbacks = {},
+    };
+
+    for (size_t i = 0; i < lib.errors.size(); ++i) {
+        if (auto cnt = lib.errors[i].load(std::memory_order_relaxed)) {
+            res.errors[static_cast<ErrorCode>(i)] = cnt;
+        }
+    }
+
+    std::lock_guard lock{lib.callbacksMtx};
+    res.callbacks.reserve(lib.callbacks.size());
+    for (const auto* cb : lib.callbacks) {
+        res.callbacks.emplace_back(cb->snapshot());
+    }
+
+    return res;
+}
+
+/**
+ * @brief Publishes runtime statistics of this process via the `sysrepo-cpp-stats` YANG module.
+ *
+ * Registers an operational data provider for the `/sysrepo-cpp-stats:sysrepo-cpp/process` list instance which belongs
+ * to the current process. The YANG module has to be installed in sysrepo. The statistics are generated on each request
+ * from the data returned by sysrepo::libraryStats.
+ *
+ * Wraps `sr_oper_get_subscribe`.
+ *
+ * @param session The session to use for the subscription.
+ * @param opts Options further changing the behavior of the subscription.
+ * @param handler Optional exception handler, see Session::onOperGet.
+ * @param callbacks Custom event loop callbacks, see Session::onOperGet.
+ *
+ * @return The Subscription handle. Statistics are published as long as it is alive.
+ */
+Subscription publishLibraryStats(Session session, const SubscribeOptions opts, ExceptionHandler handler, const std::optional<FDHandling>& callbacks)
+{
+    auto processPath = "/"s + statsModule + ":sysrepo-cpp/process[pid='" + std::to_string(getpid()) + "']";
+
+    OperGetCb cb = [processPath] (Session session, auto, auto, auto, auto, auto, std::optional<libyang::DataNode>& output) {
+        auto stats = libraryStats();
+
+        if (output) {
+            output->newPath(processPath);
+        } else {
+            output = session.getContext().newPath(processPath);
+        }
+        auto process = *output->findPath(processPath);
+
+        process.newPath("sessions-created", std::to_string(stats.sessionsCreated));
+        process.newPath("subscriptions-alive", std::to_string(stats.subscriptionsAlive));
+        process.newPath("outstanding-data", std::to_string(stats.outstandingData));
+        for (const auto& [code, count] : stats.errors) {
+            process.newPath("error[code='" + errorCodeKey(code) + "']/count", std::to_string(count));
+        }
+
+        for (const auto& cbStats : stats.callbacks) {
+            if (!cbStats.subscriptionId) {
+                // Not subscribed yet
+                continue;
+            }
+            auto cbPath = "callback[subscription-id='" + std::to_string(cbStats.subscriptionId) + "']";
+            auto cbNode = *process.newPath(cbPath);
+            cbNode.newPath("type", yangName(cbStats.type));
+            cbNode.newPath("name", cbStats.name);
+            if (cbStats.xpath) {
+                cbNode.newPath("xpath", *cbStats.xpath);
+            }
+            if (cbStats.type == CallbackType::OperGet) {
+                cbNode.newPath("shed", std::to_string(cbStats.shed));
+            }
+            fillInvocationStats(cbNode, cbStats.total);
+            for (const auto& [event, eventStats] : cbStats.perEvent) {
+                fillInvocationStats(*cbNode.newPath("event[name='"s + yangName(event) + "']"), eventStats);
+            }
+        }
+
+        return ErrorCode::Ok;
+    };
+
+    return session.onOperGet(statsModule, cb, processPath, opts, handler, callbacks);
+}
+}
@@ -6,14 +6,30 @@
  * SPDX-License-Identifier: BSD-3-Clause
 */
 
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
 #include <sysrepo-cpp/Subscription.hpp>
+#include <sysrepo-cpp/utils/queue.hpp>
 #include <sysrepo-cpp/utils/utils.hpp>
+#include <sys/eventfd.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
 extern "C" {
 #include <sysrepo.h>
 #include <sysrepo/netconf_acm.h>
 }
+#include "utils/coalesce.hpp"
 #include "utils/enum.hpp"
 #include "utils/exception.hpp"
+#include "utils/pool.hpp"
+#include "utils/probes.hpp"
+#include "utils/reaper.hpp"
+#include "utils/stats.hpp"
+#include "utils/tracing.hpp"
 #include "utils/utils.hpp"
 
 namespace sysrepo {
@@ -25,6 +41,7 @@ Subscription::Subscription(std::shared_ptr<sr_session_ctx_s> sess, ExceptionHand
     , m_exceptionHandler(std::make_unique<ExceptionHandler>(handler))
     , m_sess(sess)
     , m_didNacmInit(false)
+    , m_asyncTeardown(false)
 {
 }
 
@@ -38,12 +55,57 @@ int Subscription::eventPipe() const
     return pipe;
 }
 
+namespace {
+/**
+ * Everything that the C callbacks might still use while sysrepo is stopping the subscription.
+ */
+struct DetachedSubscription {
+    ~DetachedSubscription()
+    {
+        if (customEventLoop) {
+            sr_unsubscribe_sub(sub.get(), 0);
+        }
+    }
+
+    // The connection must outlive the subscription context, and the session holds a reference to it.
+    std::shared_ptr<sr_session_ctx_s> sess;
+    std::shared_ptr<ExceptionHandler> exceptionHandler;
+    CallbackSlab<PrivData<ModuleChangeCb>> moduleChangeCbs;
+    CallbackSlab<PrivData<OperGetCb>> operGetCbs;
+    CallbackSlab<PrivData<RpcActionCb>> RPCActionCbs;
+    CallbackSlab<PrivData<NotifCb>> notificationCbs;
+    bool customEventLoop;
+    // Declared last, so that the context goes away before the data of its callbacks.
+    std::shared_ptr<sr_subscription_ctx_s> sub;
+};
+}
+
 /**
  * Removes all subscriptions handled by this instance.
+ *
+ * See Subscription::setAsyncTeardown for making this non-blocking.
  */
 Subscription::~Subscription()
 {
-    if (m_sub && m_customEventLoopCbs) {
+    if (m_customEventLoopCbs) {
+        for (auto fd : m_wakeupFds) {
+            m_customEventLoopCbs->unregisterFd(fd);
+        }
+    }
+    if (m_sub && m_asyncTeardown) {
+        if (m_customEventLoopCbs) {
+            m_customEventLoopCbs->unregisterFd(eventPipe());
+        }
+        reapInBackground(std::make_shared<DetachedSubscription>(
+                    m_sess,
+                    std::move(m_exceptionHandler),
+                    std::move(m_moduleChangeCbs),
+                    std::move(m_operGetCbs),
+                    std::move(m_RPCActionCbs),
+                    std::move(m_notificationCbs),
+                    m_customEventLoopCbs.has_value(),
+                    std::move(m_sub)));
+    } else if (m_sub && m_customEventLoopCbs) {
         sr_unsubscribe_sub(m_sub.get(), 0);
         m_customEventLoopCbs->unregisterFd(eventPipe());
     }
@@ -59,7 +121,11 @@ Subscription::~Subscription()
 void Subscription::saveContext(sr_subscription_ctx_s* ctx)
 {
     if (!m_sub) {
-        m_sub = std::shared_ptr<sr_subscription_ctx_s>(ctx, sr_unsubscribe);
+        libraryCounters().subscriptionsAlive.fetch_add(1, std::memory_order_relaxed);
+        m_sub = std::shared_ptr<sr_subscription_ctx_s>(ctx, [] (sr_subscription_ctx_s* ctx) {
+            sr_unsubscribe(ctx);
+            libraryCounters().subscriptionsAlive.fetch_sub(1, std::memory_order_relaxed);
+        });
         if (m_customEventLoopCbs) {
             m_customEventLoopCbs->registerFd(eventPipe(), [sub = m_sub] {
                 auto res = sr_subscription_process_events(sub.get(), nullptr, nullptr);
@@ -69,7 +135,47 @@ void Subscription::saveContext(sr_subscription_ctx_s* ctx)
     }
 }
 
-namespace {
+/**
+ * Returns the sysrepo-level ID of the subscription which was created last. Internal use only.
+ */
+uint32_t Subscription::lastSubscriptionId() const
+{
+    uint32_t id;
+    auto res = sr_subscription_get_last_sub_id(m_sub.get(), &id);
+    throwIfError(res, "Couldn't retrieve the subscription ID");
+
+    return id;
+}
+
+/**
+ * Copies a Change so that it can outlive the callback. Internal use only.
+ */
+ChangeRecord toChangeRecord(const Change& change)
+{
+    return ChangeRecord{
+        .operation = change.operation,
+        .path = change.node.path(),
+        .value = change.node.isTerm() ? std::optional<std::string>{change.node.asTerm().valueStr()} : std::nullopt,
+        .previousValue = change.previousValue,
+        .previousList = change.previousList,
+        .previousDefault = change.previousDefault,
+    };
+}
+
+/**
+ * Returns an XPath which selects the whole subtrees of the nodes selected by `xpath` (or everything when there is no
+ * `xpath`), e.g., for Session::getChanges within a filtered subscription. Internal use only.
+ */
+std::string subtreeXPath(const std::optional<std::string>& xpath)
+{
+    // The parentheses keep a union (`/a | /b`) together
+    return xpath ? "(" + *xpath + ")//." : "//.";
+}
+
+/**
+ * Passes an exception thrown by a user callback to the exception handler, or terminates if there is none. Internal use
+ * only.
+ */
 void handleExceptionFromCb(std::exception& ex, std::function<void(std::exception& ex)>* exceptionHandler)
 {
     if (!*exceptionHandler) {
@@ -85,10 +191,17 @@ void handleExceptionFromCb(std::exception& ex, std::function<void(std::exception
     }
 }
 
+namespace {
 int moduleChangeCb(sr_session_ctx_t* session, uint32_t subscriptionId, const char* moduleName, const char* subXPath, sr_event_t event, uint32_t requestId, void* privateData)
 {
     auto priv = reinterpret_cast<PrivData<ModuleChangeCb>*>(privateData);
+    // The callback can be called from within the subscribing, i.e., before the ID is known otherwise
+    priv->counters->subscriptionId.store(subscriptionId, std::memory_order_relaxed);
+    SYSREPO_CPP_PROBE(module_change__entry, sr_session_get_id(session), moduleName, subXPath, event, requestId);
+    Span span{"ModuleChangeCb", session, moduleName, toEvent(event), requestId};
+    auto start = std::chrono::steady_clock::now();
     sysrepo::ErrorCode ret;
+    bool threw = false;
     try {
         ret = priv->callback(
                 wrapUnmanagedSession(session),
@@ -99,17 +212,32 @@ int moduleChangeCb(sr_session_ctx_t* session, uint32_t subscriptionId, const cha
                 requestId);
     } catch (std::exception& ex) {
         ret = ErrorCode::OperationFailed;
+        threw = true;
         handleExceptionFromCb(ex, priv->exceptionHandler);
     }
 
+    priv->counters->record(toEvent(event), ret, threw, std::chrono::steady_clock::now() - start);
+    SYSREPO_CPP_PROBE(module_change__return, sr_session_get_id(session), moduleName, subXPath, event, requestId, static_cast<int>(ret));
+    span.setResult(static_cast<int>(ret));
     return static_cast<int>(ret);
 }
 
 int operGetItemsCb(sr_session_ctx_t* session, uint32_t subscriptionId, const char* moduleName, const char* subXPath, const char* requestXPath, uint32_t requestId, lyd_node** parent, void* privateData)
 {
     auto priv = reinterpret_cast<PrivData<OperGetCb>*>(privateData);
+    priv->counters->subscriptionId.store(subscriptionId, std::memory_order_relaxed);
+    SYSREPO_CPP_PROBE(oper_get__entry, sr_session_get_id(session), moduleName, requestXPath, requestId);
+    Span span{"OperGetCb", session, requestXPath ? requestXPath : moduleName, std::nullopt, requestId};
+    auto start = std::chrono::steady_clock::now();
+    if (priv->counters->shedding.shouldShed(start)) {
+        // The provider is overloaded, so answer with no data without bothering it
+        SYSREPO_CPP_PROBE(oper_get__shed, sr_session_get_id(session), moduleName, requestXPath, requestId);
+        span.setResult(SR_ERR_OK);
+        return SR_ERR_OK;
+    }
     auto node = *parent ? std::optional{libyang::wrapRawNode(*parent)} : std::nullopt;
     sysrepo::ErrorCode ret;
+    bool threw = false;
     try {
         ret = priv->callback(
                     wrapUnmanagedSession(session),
@@ -121,6 +249,7 @@ int operGetItemsCb(sr_session_ctx_t* session, uint32_t subscriptionId, const cha
                     node);
     } catch (std::exception& ex) {
         ret = ErrorCode::OperationFailed;
+        threw = true;
         handleExceptionFromCb(ex, priv->exceptionHandler);
     }
 
@@ -132,14 +261,24 @@ int operGetItemsCb(sr_session_ctx_t* session, uint32_t subscriptionId, const cha
         *parent = libyang::releaseRawNode(*node);
     }
 
+    auto end = std::chrono::steady_clock::now();
+    priv->counters->record(std::nullopt, ret, threw, end - start);
+    priv->counters->shedding.observe(end - start, end);
+    SYSREPO_CPP_PROBE(oper_get__return, sr_session_get_id(session), moduleName, requestXPath, requestId, static_cast<int>(ret));
+    span.setResult(static_cast<int>(ret));
     return static_cast<int>(ret);
 }
 
 int rpcActionCb(sr_session_ctx_t* session, uint32_t subscriptionId, const char* operationPath, const struct lyd_node* input, sr_event_t event, uint32_t requestId, struct lyd_node* output, void* privateData)
 {
     auto priv = reinterpret_cast<PrivData<RpcActionCb>*>(privateData);
+    priv->counters->subscriptionId.store(subscriptionId, std::memory_order_relaxed);
+    SYSREPO_CPP_PROBE(rpc_action__entry, sr_session_get_id(session), operationPath, requestId);
+    Span span{"RpcActionCb", session, operationPath, toEvent(event), requestId};
+    auto start = std::chrono::steady_clock::now();
     auto outputNode = libyang::wrapRawNode(output);
     sysrepo::ErrorCode ret;
+    bool threw = false;
     try {
         ret = priv->callback(wrapUnmanagedSession(session),
                         subscriptionId,
@@ -152,18 +291,27 @@ int rpcActionCb(sr_session_ctx_t* session, uint32_t subscriptionId, const char*
 
     } catch (std::exception& ex) {
         ret = ErrorCode::OperationFailed;
+        threw = true;
         handleExceptionFromCb(ex, priv->exceptionHandler);
     }
 
     output = libyang::releaseRawNode(outputNode);
 
+    priv->counters->record(toEvent(event), ret, threw, std::chrono::steady_clock::now() - start);
+    SYSREPO_CPP_PROBE(rpc_action__return, sr_session_get_id(session), operationPath, requestId, static_cast<int>(ret));
+    span.setResult(static_cast<int>(ret));
     return static_cast<int>(ret);
 }
 
 void eventNotifCb(sr_session_ctx_t* session, uint32_t subscriptionId, const sr_ev_notif_type_t type, const struct lyd_node* notification, struct timespec* timestamp, void *privateData)
 {
     auto priv = reinterpret_cast<PrivData<NotifCb>*>(privateData);
+    priv->counters->subscriptionId.store(subscriptionId, std::memory_order_relaxed);
+    SYSREPO_CPP_PROBE(notification__entry, sr_session_get_id(session), notification ? LYD_NAME(notification) : nullptr, type);
+    Span span{"NotifCb", session, notification ? std::optional<std::string_view>{LYD_NAME(notification)} : std::nullopt};
+    auto start = std::chrono::steady_clock::now();
     auto wrappedNotification = notification ? std::optional{libyang::wrapUnmanagedRawNode(notification)} : std::nullopt;
+    bool threw = false;
     try {
         priv->callback(wrapUnmanagedSession(session),
                         subscriptionId,
@@ -173,8 +321,13 @@ void eventNotifCb(sr_session_ctx_t* session, uint32_t subscriptionId, const sr_e
                 );
 
     } catch (std::exception& ex) {
+        threw = true;
         handleExceptionFromCb(ex, priv->exceptionHandler);
     }
+
+    priv->counters->record(std::nullopt, std::nullopt, threw, std::chrono::steady_clock::now() - start);
+    SYSREPO_CPP_PROBE(notification__return, sr_session_get_id(session), notification ? LYD_NAME(notification) : nullptr, type);
+    span.setResult(threw ? SR_ERR_OPERATION_FAILED : SR_ERR_OK);
 }
 }
 
@@ -193,13 +346,351 @@ void Subscription::onModuleChange(const std::string& moduleName, ModuleChangeCb
 {
     checkNoThreadFlag(opts, m_customEventLoopCbs);
 
-    auto& privRef = m_moduleChangeCbs.emplace_back(PrivData{cb, m_exceptionHandler.get()});
+    auto slot = m_moduleChangeCbs.emplace(PrivData{cb, m_exceptionHandler.get(), std::make_shared<CallbackCounters>(CallbackType::ModuleChange, moduleName, xpath)});
+    auto& privRef = m_moduleChangeCbs[slot];
     sr_subscription_ctx_s* ctx = m_sub.get();
 
     auto res = sr_module_change_subscribe(m_sess.get(), moduleName.c_str(), xpath ? xpath->c_str() : nullptr, moduleChangeCb, reinterpret_cast<void*>(&privRef), priority, toSubscribeOptions(opts), &ctx);
+    if (res != SR_ERR_OK) {
+        m_moduleChangeCbs.erase(slot);
+    }
     throwIfError(res, "Couldn't create module change subscription", m_sess.get());
 
     saveContext(ctx);
+    privRef.counters->subscriptionId.store(lastSubscriptionId(), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Subscribe for Done events of the specified module, handing the changes over to another thread.
+ *
+ * The callback copies the changes into ChangeRecord instances, pushes them into `queue` as a single ChangeSet, and
+ * immediately returns ErrorCode::Ok. The application is supposed to pop and apply them from its own worker thread(s).
+ * This keeps the time spent in the Done event (during which the writer is still waiting for sysrepo) to a minimum.
+ * When the queue is full, the callback waits until the consumer makes some space, i.e., no changes are ever dropped.
+ *
+ * Wraps `sr_module_change_subscribe`. The SubscribeOptions::DoneOnly flag is always added.
+ *
+ * @param moduleName Name of the module to suscribe to.
+ * @param queue The queue to push the changes to.
+ * @param xpath Optional XPath that filters changes handled by this subscription.
+ * @param priority Optional priority in which the callbacks within a module are called.
+ * @param opts Options further changing the behavior of this method.
+ */
+void Subscription::onModuleChangeDeferred(const std::string& moduleName, std::shared_ptr<ChangeQueue> queue, const std::optional<std::string>& xpath, uint32_t priority, const SubscribeOptions opts)
+{
+    onModuleChange(moduleName, [queue] (Session session, auto, const std::string& moduleName, const std::optional<std::string>& subXPath, auto, uint32_t requestId) {
+        ChangeSet set{.moduleName = moduleName, .requestId = requestId, .changes = {}};
+        for (const auto& change : session.getChanges(subtreeXPath(subXPath))) {
+            set.changes.emplace_back(toChangeRecord(change));
+        }
+        queue->push(std::move(set));
+        return ErrorCode::Ok;
+    }, xpath, priority, opts | SubscribeOptions::DoneOnly);
+}
+
+/**
+ * @brief Subscribe for Done events of the specified module, merging changes of transactions which come in quick
+ * succession.
+ *
+ * The first transaction opens a window of the given length. Changes of all transactions within the window are merged
+ * into a single ChangeSet which describes the difference between the state before the window and after it. A node
+ * which was created and then deleted does not appear at all, and a leaf modified several times is reported once with
+ * its original and final value. The callback is then called once, from an internal timer thread rather than from the
+ * subscription thread. Changes which are pending when the subscription is destroyed are passed to the callback at that
+ * point.
+ *
+ * Wraps `sr_module_change_subscribe`. The SubscribeOptions::DoneOnly flag is always added.
+ *
+ * @param moduleName Name of the module to suscribe to.
+ * @param cb A callback to be called with the merged changes.
+ * @param window For how long to collect the changes.
+ * @param xpath Optional XPath that filters changes handled by this subscription.
+ * @param priority Optional priority in which the callbacks within a module are called.
+ * @param opts Options further changing the behavior of this method.
+ */
+void Subscription::onModuleChangeCoalesced(const std::string& moduleName, CoalescedChangeCb cb, std::chrono::milliseconds window, const std::optional<std::string>& xpath, uint32_t priority, const SubscribeOptions opts)
+{
+    auto coalescer = std::make_shared<ChangeCoalescer>(moduleName, cb, window, m_exceptionHandler);
+    onModuleChange(moduleName, [coalescer] (Session session, auto, auto, const std::optional<std::string>& subXPath, auto, uint32_t requestId) {
+        std::vector<ChangeRecord> changes;
+        for (const auto& change : session.getChanges(subtreeXPath(subXPath))) {
+            changes.emplace_back(toChangeRecord(change));
+        }
+        coalescer->add(requestId, std::move(changes));
+        return ErrorCode::Ok;
+    }, xpath, priority, opts | SubscribeOptions::DoneOnly);
+}
+
+namespace {
+/**
+ * Returns a copy of `tree` with the changes from a sysrepo change diff applied.
+ */
+std::optional<libyang::DataNode> applyDiff(const std::optional<libyang::DataNode>& tree, const lyd_node* diff)
+{
+    lyd_node* raw = tree ? libyang::releaseRawNode(tree->duplicateWithSiblings(libyang::DuplicationOptions::Recursive)) : nullptr;
+    if (auto err = lyd_diff_apply_all(&raw, diff); err != LY_SUCCESS) {
+        lyd_free_all(raw);
+        throw Error("Couldn't apply changes to the shadow tree (" + std::to_string(err) + ")");
+    }
+
+    return raw ? std::optional{libyang::wrapRawNode(raw)} : std::nullopt;
+}
+
+/**
+ * The last known data of a module, as seen by a ShadowModuleChangeCb.
+ */
+struct ShadowState {
+    std::optional<libyang::DataNode> shadow;
+    struct Pending {
+        // The new tree computed during the Change event, so that it does not have to be computed again for Done
+        std::optional<libyang::DataNode> tree;
+        // Whether the user callback has seen the Change event, and therefore has to see the Abort as well
+        bool delivered;
+    };
+    std::map<uint32_t, Pending> pending;
+};
+
+/**
+ * Returns true if the changes of the current event touch the data selected by `xpath`.
+ */
+bool touches(Session session, const std::optional<std::string>& xpath)
+{
+    if (!xpath) {
+        return true;
+    }
+    auto changes = session.getChanges(subtreeXPath(xpath));
+    return changes.begin() != changes.end();
+}
+}
+
+/**
+ * @brief Subscribe for changes made in the specified module, with both the old and the new data available.
+ *
+ * The library keeps a shadow copy of the module's data, which is updated from the change diff (`sr_get_change_diff`)
+ * of each Done event. For every event, the callback gets both the data before the change (the shadow copy), and the data
+ * with the change applied, without having to query the datastore. The shadow copy is filled from the initial
+ * Event::Enabled event, so SubscribeOptions::Enabled is always added. For Event::Abort, both trees contain the data which
+ * are staying, i.e., the shadow copy.
+ *
+ * The shadow copy always holds the data of the whole module, so the subscription itself is made for the whole module.
+ * The `xpath` filter is applied by the library: the callback is only called for the changes which touch the selected
+ * data (and for the initial Event::Enabled), but the trees it gets are still complete.
+ *
+ * Wraps `sr_module_change_subscribe`.
+ *
+ * @param moduleName Name of the module to suscribe to.
+ * @param cb A callback to be called when a change in the datastore occurs.
+ * @param xpath Optional XPath that filters changes handled by this subscription.
+ * @param priority Optional priority in which the callbacks within a module are called.
+ * @param opts Options further changing the behavior of this method.
+ */
+void Subscription::onModuleChangeShadowed(const std::string& moduleName, ShadowModuleChangeCb cb, const std::optional<std::string>& xpath, uint32_t priority, const SubscribeOptions opts)
+{
+    // Events of a single subscription are never delivered concurrently, so this needs no locking.
+    auto state = std::make_shared<ShadowState>();
+    onModuleChange(moduleName, [cb, xpath, state] (Session session, uint32_t subscriptionId, const std::string& moduleName, auto, Event event, uint32_t requestId) {
+        auto pending = state->pending.find(requestId);
+
+        if (event == Event::Abort) {
+            // The change is being rolled back, the shadow tree still holds the data which are going to stay
+            if (pending == state->pending.end()) {
+                return ErrorCode::Ok;
+            }
+            auto delivered = pending->second.delivered;
+            state->pending.erase(pending);
+            return delivered ? cb(session, subscriptionId, moduleName, xpath, event, requestId, state->shadow, state->shadow) : ErrorCode::Ok;
+        }
+
+        std::optional<libyang::DataNode> newTree;
+        bool relevant;
+        if (event == Event::Done && pending != state->pending.end()) {
+            newTree = std::move(pending->second.tree);
+            relevant = pending->second.delivered;
+            state->pending.erase(pending);
+        } else {
+            newTree = applyDiff(state->shadow, sr_get_change_diff(getRawSession(session)));
+            relevant = event == Event::Enabled || touches(session, xpath);
+        }
+
+        auto ret = relevant ? cb(session, subscriptionId, moduleName, xpath, event, requestId, state->shadow, newTree) : ErrorCode::Ok;
+        if (event == Event::Done) {
+            state->shadow = std::move(newTree);
+        } else if ((event == Event::Change || event == Event::Enabled) && ret == ErrorCode::Ok) {
+            state->pending[requestId] = ShadowState::Pending{.tree = std::move(newTree), .delivered = relevant};
+        }
+        return ret;
+    }, std::nullopt, priority, opts | SubscribeOptions::Enabled);
+}
+
+/**
+ * @brief All events of one AsyncModuleChangeCb which have not been reported back to sysrepo yet. Internal use only.
+ */
+struct AsyncChanges {
+    AsyncChanges()
+        : wakeup(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+    {
+        if (wakeup == -1) {
+            throw std::system_error{errno, std::system_category(), "Couldn't create the wakeup eventfd"};
+        }
+    }
+
+    ~AsyncChanges()
+    {
+        close(wakeup);
+    }
+
+    AsyncChanges(const AsyncChanges&) = delete;
+    AsyncChanges& operator=(const AsyncChanges&) = delete;
+
+    // Always locked before PendingChange::mtx.
+    std::mutex mtx;
+    std::map<std::pair<uint32_t, Event>, std::shared_ptr<PendingChange>> pending;
+    // Events delivered by this thread come from within sr_module_change_subscribe, which does not support shelving
+    std::optional<std::thread::id> subscribingThread;
+    // Signalled when a shelved event is completed, so that the event loop processes the subscription again
+    const int wakeup;
+};
+
+/**
+ * @brief State of a single module change event handled by an AsyncModuleChangeCb. Internal use only.
+ */
+struct PendingChange {
+    enum class Stage {
+        InCallback, /**< The callback is running, the result is returned directly once it finishes. */
+        Waiting, /**< The event cannot be shelved, the trampoline is waiting for the result. */
+        Shelved, /**< The trampoline has returned ErrorCode::CallbackShelve, the event has to be redelivered. */
+        Delivered, /**< The result has been passed to sysrepo. */
+    };
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    Stage stage = Stage::InCallback;
+    std::optional<ErrorCode> result;
+    std::weak_ptr<AsyncChanges> changes;
+};
+
+/**
+ * @brief Subscribe for changes made in the specified module, with the changes processed asynchronously.
+ *
+ * Built on top of Subscription::onModuleChange. When an event arrives, the callback is called and the event is shelved
+ * via ErrorCode::CallbackShelve until the callback's ChangeCompletion is completed. Completing a shelved event signals
+ * an eventfd which is registered with the custom event loop (see FDHandling). The event loop then processes the
+ * subscription again, sysrepo redelivers the shelved event, and the stored result is returned this time. If the
+ * callback completes the event before returning, the result is returned right away.
+ *
+ * All events are therefore processed by the thread which runs the event loop. This requires a custom event loop, i.e.,
+ * the Subscription has to be created with FDHandling and SubscribeOptions::NoThread.
+ *
+ * The events delivered from within this call (with SubscribeOptions::Enabled) cannot be shelved, so this call waits
+ * until they are completed. These events have to be completed from another thread than the one which subscribes.
+ *
+ * @param moduleName Name of the module to suscribe to.
+ * @param cb A callback to be called when a change in the datastore occurs.
+ * @param xpath Optional XPath that filters changes handled by this subscription.
+ * @param priority Optional priority in which the callbacks within a module are called.
+ * @param opts Options further changing the behavior of this method.
+ */
+void Subscription::onModuleChangeAsync(const std::string& moduleName, AsyncModuleChangeCb cb, const std::optional<std::string>& xpath, uint32_t priority, const SubscribeOptions opts)
+{
+    if (!m_customEventLoopCbs) {
+        throw Error("Subscription::onModuleChangeAsync: a custom event loop (FDHandling) is required");
+    }
+
+    auto state = std::make_shared<AsyncChanges>();
+    state->subscribingThread = std::this_thread::get_id();
+
+    onModuleChange(moduleName, [cb, state] (Session session, uint32_t subscriptionId, const std::string& moduleName, const std::optional<std::string>& subXPath, Event event, uint32_t requestId) {
+        auto key = std::pair{requestId, event};
+        std::shared_ptr<PendingChange> pending;
+        bool canShelve;
+        {
+            std::lock_guard lock{state->mtx};
+            if (auto it = state->pending.find(key); it != state->pending.end()) {
+                // This is a redelivery of a shelved event
+                pending = it->second;
+                std::lock_guard pendingLock{pending->mtx};
+                if (!pending->result) {
+                    return ErrorCode::CallbackShelve;
+                }
+                state->pending.erase(it);
+                pending->stage = PendingChange::Stage::Delivered;
+                return *pending->result;
+            }
+
+            canShelve = state->subscribingThread != std::this_thread::get_id();
+            pending = std::make_shared<PendingChange>();
+            pending->changes = state;
+            state->pending.emplace(key, pending);
+        }
+
+        try {
+            cb(session, subscriptionId, moduleName, subXPath, event, requestId, ChangeCompletion{pending});
+        } catch (...) {
+            std::lock_guard lock{state->mtx};
+            state->pending.erase(key);
+            throw;
+        }
+
+        std::lock_guard lock{state->mtx};
+        std::unique_lock pendingLock{pending->mtx};
+        if (!pending->result && !canShelve) {
+            pending->stage = PendingChange::Stage::Waiting;
+            pending->cv.wait(pendingLock, [&pending] { return pending->result.has_value(); });
+        }
+
+        if (!pending->result) {
+            pending->stage = PendingChange::Stage::Shelved;
+            return ErrorCode::CallbackShelve;
+        }
+        state->pending.erase(key);
+        pending->stage = PendingChange::Stage::Delivered;
+        return *pending->result;
+    }, xpath, priority, opts);
+
+    {
+        std::lock_guard lock{state->mtx};
+        state->subscribingThread.reset();
+    }
+
+    m_customEventLoopCbs->registerFd(state->wakeup, [sub = m_sub, state] {
+        uint64_t count;
+        // The counter might have been reset by an earlier wakeup already
+        [[maybe_unused]] auto ignored = read(state->wakeup, &count, sizeof(count));
+        auto res = sr_subscription_process_events(sub.get(), nullptr, nullptr);
+        throwIfError(res, "Couldn't process events");
+    });
+    m_wakeupFds.emplace_back(state->wakeup);
+}
+
+ChangeCompletion::ChangeCompletion(std::shared_ptr<PendingChange> pending)
+    : m_pending(pending)
+{
+}
+
+/**
+ * Reports the result of the asynchronously processed event. If the event has been shelved already, this wakes up the
+ * custom event loop of the subscription, which then passes the result on. Does not process any events by itself.
+ *
+ * @param result The result of the event, as would be returned from a ModuleChangeCb.
+ */
+void ChangeCompletion::complete(ErrorCode result)
+{
+    std::lock_guard lock{m_pending->mtx};
+    if (m_pending->result) {
+        throw Error("ChangeCompletion::complete: already completed");
+    }
+    m_pending->result = result;
+    m_pending->cv.notify_all();
+
+    if (m_pending->stage != PendingChange::Stage::Shelved) {
+        // The trampoline is still running and picks up the result by itself
+        return;
+    }
+    if (auto changes = m_pending->changes.lock()) {
+        uint64_t one = 1;
+        // Only fails when the counter would overflow, and then the event loop is going to be woken up anyway
+        [[maybe_unused]] auto ignored = write(changes->wakeup, &one, sizeof(one));
+    }
 }
 
 /**
@@ -216,12 +707,100 @@ void Subscription::onOperGet(const std::string& moduleName, OperGetCb cb, const
 {
     checkNoThreadFlag(opts, m_customEventLoopCbs);
 
-    auto& privRef = m_operGetCbs.emplace_back(PrivData{cb, m_exceptionHandler.get()});
+    auto slot = m_operGetCbs.emplace(PrivData{cb, m_exceptionHandler.get(), std::make_shared<CallbackCounters>(CallbackType::OperGet, moduleName, xpath)});
+    auto& privRef = m_operGetCbs[slot];
     sr_subscription_ctx_s* ctx = m_sub.get();
     auto res = sr_oper_get_subscribe(m_sess.get(), moduleName.c_str(), xpath ? xpath->c_str() : nullptr, operGetItemsCb, reinterpret_cast<void*>(&privRef), toSubscribeOptions(opts), &ctx);
+    if (res != SR_ERR_OK) {
+        m_operGetCbs.erase(slot);
+    }
     throwIfError(res, "Couldn't create operational get items subscription", m_sess.get());
 
     saveContext(ctx);
+    privRef.counters->subscriptionId.store(lastSubscriptionId(), std::memory_order_relaxed);
+}
+
+namespace {
+libyang::DataNode treeRoot(libyang::DataNode node)
+{
+    while (auto parent = node.parent()) {
+        node = *parent;
+    }
+    return node.firstSibling();
+}
+}
+
+/**
+ * @brief Subscribe for providing operational data at the given xpath, with the data coming from several independent
+ * sources.
+ *
+ * Each of the `shards` (e.g., one for each line card) provides its part of the data. For every request, all shards are
+ * called concurrently, each building its own tree, and their trees are merged (`lyd_merge_siblings`) into the output
+ * once they have all finished. The request therefore takes as long as the slowest shard rather than the sum of all of
+ * them. The shards run on threads owned by this subscription; each shard gets the same parameters as an OperGetCb,
+ * except that `output` is a copy of the parent node (or std::nullopt) private to that shard. The session must not be
+ * modified from the shards.
+ *
+ * If any shard fails, the first failure (in the order of `shards`) is returned, and no data are provided.
+ *
+ * Wraps `sr_oper_get_subscribe`.
+ *
+ * @param moduleName Name of the module to suscribe to.
+ * @param shards The callbacks which provide the parts of the data.
+ * @param xpath XPath that identifies which data this subscription is able to provide.
+ * @param opts Options further changing the behavior of this method.
+ */
+void Subscription::onOperGetSharded(const std::string& moduleName, std::vector<OperGetCb> shards, const std::optional<std::string>& xpath, const SubscribeOptions opts)
+{
+    if (shards.empty()) {
+        throw Error{"onOperGetSharded: no shards"};
+    }
+
+    // The subscription thread runs one of the shards itself
+    auto pool = std::make_shared<WorkerPool>(shards.size() - 1);
+    onOperGet(moduleName, [pool, shards = std::move(shards)] (Session session, uint32_t subscriptionId, const std::string& moduleName, const std::optional<std::string>& subXPath, const std::optional<std::string>& requestXPath, uint32_t requestId, std::optional<libyang::DataNode>& output) {
+        std::vector<std::optional<libyang::DataNode>> outputs(shards.size());
+        std::vector<ErrorCode> results(shards.size(), ErrorCode::Ok);
+        std::vector<std::exception_ptr> errors(shards.size());
+        std::vector<std::function<void()>> tasks;
+        for (size_t i = 0; i < shards.size(); ++i) {
+            if (output) {
+                outputs[i] = output->duplicate(libyang::DuplicationOptions::WithParents);
+            }
+            tasks.emplace_back([&, i] {
+                try {
+                    results[i] = shards[i](session, subscriptionId, moduleName, subXPath, requestXPath, requestId, outputs[i]);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+
+        pool->runAll(tasks);
+
+        for (size_t i = 0; i < shards.size(); ++i) {
+            if (errors[i]) {
+                std::rethrow_exception(errors[i]);
+            }
+            if (results[i] != ErrorCode::Ok) {
+                return results[i];
+            }
+        }
+
+        for (auto& shardOutput : outputs) {
+            if (!shardOutput) {
+                continue;
+            }
+            if (!output) {
+                output = treeRoot(*shardOutput);
+                continue;
+            }
+            auto root = treeRoot(*output);
+            root.merge(treeRoot(*shardOutput));
+        }
+
+        return ErrorCode::Ok;
+    }, xpath, opts);
 }
 
 /**
@@ -238,12 +817,17 @@ void Subscription::onRPCAction(const std::string& xpath, RpcActionCb cb, uint32_
 {
     checkNoThreadFlag(opts, m_customEventLoopCbs);
 
-    auto& privRef = m_RPCActionCbs.emplace_back(PrivData{cb, m_exceptionHandler.get()});
+    auto slot = m_RPCActionCbs.emplace(PrivData{cb, m_exceptionHandler.get(), std::make_shared<CallbackCounters>(CallbackType::RPCAction, xpath, xpath)});
+    auto& privRef = m_RPCActionCbs[slot];
     sr_subscription_ctx_s* ctx = m_sub.get();
     auto res = sr_rpc_subscribe_tree(m_sess.get(), xpath.c_str(), rpcActionCb, reinterpret_cast<void*>(&privRef), priority, toSubscribeOptions(opts), &ctx);
+    if (res != SR_ERR_OK) {
+        m_RPCActionCbs.erase(slot);
+    }
     throwIfError(res, "Couldn't create RPC/action subscription", m_sess.get());
 
     saveContext(ctx);
+    privRef.counters->subscriptionId.store(lastSubscriptionId(), std::memory_order_relaxed);
 }
 
 /**
@@ -268,7 +852,8 @@ void Subscription::onNotification(
 {
     checkNoThreadFlag(opts, m_customEventLoopCbs);
 
-    auto& privRef = m_notificationCbs.emplace_back(PrivData{cb, m_exceptionHandler.get()});
+    auto slot = m_notificationCbs.emplace(PrivData{cb, m_exceptionHandler.get(), std::make_shared<CallbackCounters>(CallbackType::Notification, moduleName, xpath)});
+    auto& privRef = m_notificationCbs[slot];
     sr_subscription_ctx_s* ctx = m_sub.get();
     auto startSpec = startTime ? std::optional{toTimespec(*startTime)} : std::nullopt;
     auto stopSpec = stopTime ? std::optional{toTimespec(*stopTime)} : std::nullopt;
@@ -282,9 +867,397 @@ void Subscription::onNotification(
             reinterpret_cast<void*>(&privRef),
             toSubscribeOptions(opts),
             &ctx);
+    if (res != SR_ERR_OK) {
+        m_notificationCbs.erase(slot);
+    }
     throwIfError(res, "Couldn't create notification subscription", m_sess.get());
 
     saveContext(ctx);
+    privRef.counters->subscriptionId.store(lastSubscriptionId(), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Subscribe for the delivery of a notification, storing the notifications into a buffer instead of handling
+ * them right away.
+ *
+ * The callback copies each notification (including the events with no YANG-level notification) into `ring` and
+ * returns. The application pops them from the ring whenever it likes, so a slow consumer does not hold up the delivery
+ * of notifications by sysrepo. What happens when the ring is full depends on its OverflowPolicy.
+ *
+ * Wraps `sr_notif_subscribe_tree`.
+ *
+ * @param ring The buffer for the received notifications.
+ *
+ * See Subscription::onNotification for the description of the other parameters.
+ */
+void Subscription::onNotificationQueued(
+        const std::string& moduleName,
+        std::shared_ptr<NotificationRing> ring,
+        const std::optional<std::string>& xpath,
+        const std::optional<NotificationTimeStamp>& startTime,
+        const std::optional<NotificationTimeStamp>& stopTime,
+        const SubscribeOptions opts)
+{
+    onNotification(moduleName, [ring] (auto, auto, const NotificationType type, const std::optional<libyang::DataNode> tree, const NotificationTimeStamp timestamp) {
+        ring->push({
+            .type = type,
+            .tree = tree ? std::optional{tree->duplicate(libyang::DuplicationOptions::Recursive | libyang::DuplicationOptions::WithParents)} : std::nullopt,
+            .timestamp = timestamp,
+        });
+    }, xpath, startTime, stopTime, opts);
+}
+
+/**
+ * @param capacity The maximal number of notifications in the ring, rounded up to a power of two.
+ * @param policy What to do with a notification which does not fit.
+ */
+NotificationRing::NotificationRing(size_t capacity, OverflowPolicy policy)
+    : m_queue(std::make_unique<BoundedQueue<ReceivedNotification>>(capacity))
+    , m_policy(policy)
+{
+}
+
+NotificationRing::~NotificationRing() = default;
+
+/**
+ * Stores a notification, according to the OverflowPolicy if the ring is full. Called by the subscription.
+ */
+void NotificationRing::push(ReceivedNotification&& notification)
+{
+    // Counted before pushing, so that a consumer popping the notification right away does not see the count go below zero
+    auto size = m_size.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    switch (m_policy) {
+    case OverflowPolicy::DropOldest:
+        while (!m_queue->tryPush(std::move(notification))) {
+            if (m_queue->tryPop()) {
+                popped();
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        break;
+    case OverflowPolicy::DropNewest:
+        if (!m_queue->tryPush(std::move(notification))) {
+            popped();
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        break;
+    case OverflowPolicy::Block:
+        m_queue->push(std::move(notification));
+        break;
+    }
+
+    size = std::min(size, capacity());
+    auto highWaterMark = m_highWaterMark.load(std::memory_order_relaxed);
+    while (size > highWaterMark && !m_highWaterMark.compare_exchange_weak(highWaterMark, size, std::memory_order_relaxed)) {
+    }
+}
+
+void NotificationRing::popped()
+{
+    m_size.fetch_sub(1, std::memory_order_relaxed);
+}
+
+/**
+ * Takes the oldest notification out of the ring, unless the ring is empty.
+ */
+std::optional<ReceivedNotification> NotificationRing::tryPop()
+{
+    auto res = m_queue->tryPop();
+    if (res) {
+        popped();
+    }
+    return res;
+}
+
+/**
+ * Takes the oldest notification out of the ring. If the ring is empty, sleeps until a notification arrives.
+ */
+ReceivedNotification NotificationRing::pop()
+{
+    auto res = m_queue->pop();
+    popped();
+    return res;
+}
+
+size_t NotificationRing::capacity() const
+{
+    return m_queue->capacity();
+}
+
+/**
+ * Returns the number of notifications dropped because the ring was full.
+ */
+uint64_t NotificationRing::dropped() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+/**
+ * Returns the highest number of notifications which were in the ring at once.
+ */
+size_t NotificationRing::highWaterMark() const
+{
+    return m_highWaterMark.load(std::memory_order_relaxed);
+}
+
+/**
+ * Returns runtime statistics of all callbacks registered in this Subscription.
+ *
+ * The counters are updated by the subscription thread (or whoever processes the events), so it is safe to call this
+ * method while the callbacks are running. Each callback is, however, snapshotted separately, so the numbers of
+ * different callbacks might come from slightly different points in time.
+ */
+std::vector<CallbackStats> Subscription::stats() const
+{
+    std::vector<CallbackStats> res;
+    auto collect = [&res] (const auto& privs) {
+        privs.forEach([&res] (const auto& priv) {
+            res.emplace_back(priv.counters->snapshot());
+        });
+    };
+
+    collect(m_moduleChangeCbs);
+    collect(m_operGetCbs);
+    collect(m_RPCActionCbs);
+    collect(m_notificationCbs);
+
+    return res;
+}
+
+/**
+ * Removes a single callback, identified by its sysrepo-level subscription ID. The rest of the callbacks in this instance,
+ * as well as the subscription thread, are left untouched.
+ *
+ * Wraps `sr_unsubscribe_sub`. Once this returns, the callback is not running and it will not be called again.
+ *
+ * @param subscriptionId The ID of the callback, as passed to the callback itself or as reported by Subscription::stats.
+ */
+void Subscription::unsubscribe(uint32_t subscriptionId)
+{
+    auto matches = [subscriptionId] (const auto& priv) { return priv.counters->subscriptionId.load(std::memory_order_relaxed) == subscriptionId; };
+    bool found = false;
+    auto lookup = [&found, &matches] (const auto& priv) { found = found || matches(priv); };
+    m_moduleChangeCbs.forEach(lookup);
+    m_operGetCbs.forEach(lookup);
+    m_RPCActionCbs.forEach(lookup);
+    m_notificationCbs.forEach(lookup);
+    if (!found) {
+        // This also rejects the ID 0, which would make sysrepo drop all callbacks at once.
+        throw Error("Subscription::unsubscribe: no callback with ID " + std::to_string(subscriptionId));
+    }
+
+    auto res = sr_unsubscribe_sub(m_sub.get(), subscriptionId);
+    throwIfError(res, "Couldn't unsubscribe", m_sess.get());
+
+    m_moduleChangeCbs.eraseIf(matches);
+    m_operGetCbs.eraseIf(matches);
+    m_RPCActionCbs.eraseIf(matches);
+    m_notificationCbs.eraseIf(matches);
+}
+
+/**
+ * Suspends a single callback. Sysrepo does not deliver any events to it until it is resumed, and it generates the
+ * NotificationType::Suspended notification for notification subscriptions.
+ *
+ * Wraps `sr_subscription_suspend`.
+ *
+ * @param subscriptionId The ID of the callback.
+ */
+void Subscription::suspend(uint32_t subscriptionId)
+{
+    auto res = sr_subscription_suspend(m_sub.get(), subscriptionId);
+    throwIfError(res, "Couldn't suspend subscription " + std::to_string(subscriptionId));
+}
+
+/**
+ * Resumes a callback suspended by Subscription::suspend.
+ *
+ * Wraps `sr_subscription_resume`.
+ *
+ * @param subscriptionId The ID of the callback.
+ */
+void Subscription::resume(uint32_t subscriptionId)
+{
+    auto res = sr_subscription_resume(m_sub.get(), subscriptionId);
+    throwIfError(res, "Couldn't resume subscription " + std::to_string(subscriptionId));
+}
+
+/**
+ * Checks whether a callback is suspended.
+ *
+ * Wraps `sr_subscription_get_suspended`.
+ *
+ * @param subscriptionId The ID of the callback.
+ */
+bool Subscription::isSuspended(uint32_t subscriptionId) const
+{
+    int suspended;
+    auto res = sr_subscription_get_suspended(m_sub.get(), subscriptionId, &suspended);
+    throwIfError(res, "Couldn't retrieve the suspend state of subscription " + std::to_string(subscriptionId));
+
+    return suspended;
+}
+
+/**
+ * Suspends a single callback until the returned guard is destroyed.
+ *
+ * @param subscriptionId The ID of the callback.
+ */
+SuspendGuard Subscription::suspendScoped(uint32_t subscriptionId)
+{
+    suspend(subscriptionId);
+    return SuspendGuard{m_sub, subscriptionId};
+}
+
+/**
+ * Stops the handler thread of this subscription. Events are queued and they are processed once the thread is resumed.
+ * The Subscription must have been created with SubscribeOptions::ThreadSuspend.
+ *
+ * Wraps `sr_subscription_thread_suspend`.
+ */
+void Subscription::suspendThread()
+{
+    auto res = sr_subscription_thread_suspend(m_sub.get());
+    throwIfError(res, "Couldn't suspend the subscription thread");
+}
+
+/**
+ * Resumes the handler thread stopped by Subscription::suspendThread.
+ *
+ * Wraps `sr_subscription_thread_resume`.
+ */
+void Subscription::resumeThread()
+{
+    auto res = sr_subscription_thread_resume(m_sub.get());
+    throwIfError(res, "Couldn't resume the subscription thread");
+}
+
+/**
+ * Stops the handler thread of this subscription until the returned guard is destroyed.
+ */
+SuspendGuard Subscription::suspendThreadScoped()
+{
+    suspendThread();
+    return SuspendGuard{m_sub, std::nullopt};
+}
+
+/**
+ * @brief Sheds the load of an expensive operational data provider.
+ *
+ * When an invocation of the callback takes longer than LoadSheddingPolicy::latencyThreshold, the following requests
+ * within the LoadSheddingPolicy::cooldown period are answered with no data straight away, without calling the callback.
+ * Unlike Subscription::suspend, this happens automatically, it is reverted automatically, and it can be safely
+ * triggered from within the subscription thread. The shed requests are reported in CallbackStats::shed.
+ *
+ * @param subscriptionId The ID of an operational data callback.
+ * @param policy The thresholds to use, std::nullopt disables the shedding.
+ */
+void Subscription::setLoadShedding(uint32_t subscriptionId, const std::optional<LoadSheddingPolicy>& policy)
+{
+    bool found = false;
+    m_operGetCbs.forEach([&found, subscriptionId, &policy] (const auto& priv) {
+        if (priv.counters->subscriptionId.load(std::memory_order_relaxed) == subscriptionId) {
+            priv.counters->shedding.configure(policy);
+            found = true;
+        }
+    });
+
+    if (!found) {
+        throw Error("Subscription::setLoadShedding: no operational data callback with ID " + std::to_string(subscriptionId));
+    }
+}
+
+/**
+ * @brief Makes the destructor of this instance non-blocking.
+ *
+ * Normally, the destructor waits until sysrepo has stopped the handler thread and cleaned up its shared memory, which
+ * might take a while. With this enabled, the subscription context (together with the callbacks, which might still be
+ * running until then) is handed over to a background thread, and the destructor returns right away. The callbacks might
+ * therefore be invoked for a short while after the destructor returns, so anything they reference must stay alive.
+ *
+ * Use sysrepo::waitForBackgroundTeardown to wait until all such subscriptions are gone, e.g., before the process exits.
+ */
+void Subscription::setAsyncTeardown(bool enabled)
+{
+    m_asyncTeardown = enabled;
+}
+
+/**
+ * @brief Tears down many subscriptions at once, in parallel.
+ *
+ * Meant for process shutdown. Tearing subscriptions down one after another takes as long as all of them together,
+ * since each one waits for its handler thread. This destroys them from up to `parallelism` threads at once, and then
+ * waits for all background teardowns (see Subscription::setAsyncTeardown) to finish as well.
+ */
+void unsubscribeAll(std::vector<Subscription> subscriptions, unsigned parallelism)
+{
+    for (auto& sub : subscriptions) {
+        sub.setAsyncTeardown(false);
+    }
+
+    std::atomic<size_t> next = 0;
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < std::min<size_t>(std::max(parallelism, 1u), subscriptions.size()); ++i) {
+        workers.emplace_back([&subscriptions, &next] {
+            for (auto idx = next++; idx < subscriptions.size(); idx = next++) {
+                auto doomed = std::move(subscriptions[idx]);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    waitForBackgroundTeardown();
+}
+
+/**
+ * Blocks until all subscriptions destroyed with Subscription::setAsyncTeardown enabled are completely gone.
+ */
+void waitForBackgroundTeardown()
+{
+    waitForReaper();
+}
+
+SuspendGuard::SuspendGuard(std::shared_ptr<sr_subscription_ctx_s> sub, std::optional<uint32_t> subscriptionId)
+    : m_sub(sub)
+    , m_subscriptionId(subscriptionId)
+{
+}
+
+/**
+ * Resumes the subscription.
+ */
+SuspendGuard::~SuspendGuard()
+{
+    auto sub = m_sub.lock();
+    if (!sub) {
+        // Moved from, or the Subscription is already gone
+        return;
+    }
+
+    auto res = m_subscriptionId ? sr_subscription_resume(sub.get(), *m_subscriptionId) : sr_subscription_thread_resume(sub.get());
+    if (res != SR_ERR_OK) {
+        SRPLG_LOG_WRN("sysrepo-cpp", "Couldn't resume a suspended subscription: %s", sr_strerror(res));
+    }
+}
+
+SuspendGuard::SuspendGuard(SuspendGuard&& other) noexcept
+    : m_sub(std::move(other.m_sub))
+    , m_subscriptionId(other.m_subscriptionId)
+{
+}
+
+SuspendGuard& SuspendGuard::operator=(SuspendGuard&& other) noexcept
+{
+    if (this != &other) {
+        auto previous = std::move(*this);
+        m_sub = std::move(other.m_sub);
+        m_subscriptionId = other.m_subscriptionId;
+    }
+    return *this;
 }
 
 Subscription::Subscription(Subscription&& other) noexcept = default;
@@ -318,6 +1291,61 @@ ChangeIterator ChangeCollection::end() const
     return ChangeIterator{ChangeIterator::iterator_end_tag{}};
 }
 
+namespace {
+std::optional<libyang::DataNode> enclosingListInstance(const libyang::DataNode& node)
+{
+    for (auto parent = node.parent(); parent; parent = parent->parent()) {
+        if (parent->schema().nodeType() == libyang::NodeType::List) {
+            return parent;
+        }
+    }
+
+    return std::nullopt;
+}
+}
+
+/**
+ * @brief Groups changes by the list instance they belong to.
+ *
+ * Goes through the changes once. The list instances are looked up by the address of their node in the change tree,
+ * and their keys are only extracted once per instance. Changes of nodes which are not within any list instance are
+ * skipped.
+ *
+ * @return One ListInstanceChange for each list instance which was created, deleted, moved, or which contains a changed
+ * node, in the order in which they were first encountered.
+ */
+std::vector<ListInstanceChange> groupByListInstance(const ChangeCollection& changes)
+{
+    std::vector<ListInstanceChange> res;
+    std::unordered_map<const lyd_node*, size_t> index;
+
+    auto recordFor = [&res, &index] (const libyang::DataNode& instance) -> ListInstanceChange& {
+        auto [it, inserted] = index.try_emplace(libyang::getRawNode(instance), res.size());
+        if (inserted) {
+            std::vector<std::pair<std::string, std::string>> keys;
+            // Keys are always the first children of a list instance
+            for (const auto& child : instance.immediateChildren()) {
+                if (!child.schema().isKey()) {
+                    break;
+                }
+                keys.emplace_back(child.schema().name(), child.asTerm().valueStr());
+            }
+            res.emplace_back(ListInstanceChange{ChangeOperation::Modified, instance, std::move(keys), {}});
+        }
+        return res[it->second];
+    };
+
+    for (const auto& change : changes) {
+        if (change.node.schema().nodeType() == libyang::NodeType::List) {
+            recordFor(change.node).operation = change.operation;
+        } else if (auto instance = enclosingListInstance(change.node)) {
+            recordFor(*instance).changes.emplace_back(change);
+        }
+    }
+
+    return res;
+}
+
 /**
  * Wraps `sr_change_iter_s`.
  */
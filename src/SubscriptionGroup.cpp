@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <cinttypes>
+#include <mutex>
+#include <sysrepo-cpp/SubscriptionGroup.hpp>
+extern "C" {
+#include <sysrepo.h>
+}
+
+namespace sysrepo {
+/**
+ * @brief The shared part of a SubscriptionGroup. Internal use only.
+ */
+struct SubscriptionHandle::GroupState {
+    explicit GroupState(Subscription&& sub)
+        : sub(std::move(sub))
+    {
+    }
+
+    // Guards both the sysrepo subscription context and the callback storage inside of the Subscription.
+    mutable std::mutex mtx;
+    Subscription sub;
+};
+
+/**
+ * Creates a group with no callbacks. The sysrepo subscription context is created with the first callback.
+ *
+ * @param session The session which will be used for subscribing.
+ * @param handler Optional exception handler that will be called when an exception occurs in a user callback. It is tied
+ * to all of the callbacks in the group.
+ * @param callbacks Custom event loop callbacks that are called when the subscription context is created and destroyed.
+ * If this argument is used, all callbacks in this group must be registered with SubscribeOptions::NoThread.
+ */
+SubscriptionGroup::SubscriptionGroup(Session session, ExceptionHandler handler, const std::optional<FDHandling>& callbacks)
+    : m_state(std::make_shared<SubscriptionHandle::GroupState>(Subscription{session.m_sess, handler, callbacks}))
+{
+}
+
+/**
+ * Subscribe for changes made in the specified module.
+ *
+ * See Subscription::onModuleChange for the description of the parameters.
+ *
+ * @return A handle which keeps this callback registered.
+ */
+SubscriptionHandle SubscriptionGroup::onModuleChange(const std::string& moduleName, ModuleChangeCb cb, const std::optional<std::string>& xpath, uint32_t priority, const SubscribeOptions opts)
+{
+    std::lock_guard lock{m_state->mtx};
+    m_state->sub.onModuleChange(moduleName, cb, xpath, priority, opts);
+    return SubscriptionHandle{m_state, m_state->sub.lastSubscriptionId()};
+}
+
+/**
+ * Subscribe for providing operational data at the given xpath.
+ *
+ * See Subscription::onOperGet for the description of the parameters.
+ *
+ * @return A handle which keeps this callback registered.
+ */
+SubscriptionHandle SubscriptionGroup::onOperGet(const std::string& moduleName, OperGetCb cb, const std::optional<std::string>& xpath, const SubscribeOptions opts)
+{
+    std::lock_guard lock{m_state->mtx};
+    m_state->sub.onOperGet(moduleName, cb, xpath, opts);
+    return SubscriptionHandle{m_state, m_state->sub.lastSubscriptionId()};
+}
+
+/**
+ * Subscribe for the delivery of an RPC/action.
+ *
+ * See Subscription::onRPCAction for the description of the parameters.
+ *
+ * @return A handle which keeps this callback registered.
+ */
+SubscriptionHandle SubscriptionGroup::onRPCAction(const std::string& xpath, RpcActionCb cb, uint32_t priority, const SubscribeOptions opts)
+{
+    std::lock_guard lock{m_state->mtx};
+    m_state->sub.onRPCAction(xpath, cb, priority, opts);
+    return SubscriptionHandle{m_state, m_state->sub.lastSubscriptionId()};
+}
+
+/**
+ * Subscribe for the delivery of a notification.
+ *
+ * See Subscription::onNotification for the description of the parameters.
+ *
+ * @return A handle which keeps this callback registered.
+ */
+SubscriptionHandle SubscriptionGroup::onNotification(
+        const std::string& moduleName,
+        NotifCb cb,
+        const std::optional<std::string>& xpath,
+        const std::optional<NotificationTimeStamp>& startTime,
+        const std::optional<NotificationTimeStamp>& stopTime,
+        const SubscribeOptions opts)
+{
+    std::lock_guard lock{m_state->mtx};
+    m_state->sub.onNotification(moduleName, cb, xpath, startTime, stopTime, opts);
+    return SubscriptionHandle{m_state, m_state->sub.lastSubscriptionId()};
+}
+
+/**
+ * Returns runtime statistics of all callbacks which are currently registered in this group.
+ */
+std::vector<CallbackStats> SubscriptionGroup::stats() const
+{
+    std::lock_guard lock{m_state->mtx};
+    return m_state->sub.stats();
+}
+
+SubscriptionHandle::SubscriptionHandle(std::shared_ptr<GroupState> group, uint32_t subscriptionId)
+    : m_group(group)
+    , m_subscriptionId(subscriptionId)
+{
+}
+
+/**
+ * Unsubscribes the callback, unless it has been unsubscribed already.
+ */
+SubscriptionHandle::~SubscriptionHandle()
+{
+    try {
+        unsubscribe();
+    } catch (std::exception& ex) {
+        SRPLG_LOG_WRN("sysrepo-cpp", "Couldn't unsubscribe callback %" PRIu32 ": %s", m_subscriptionId, ex.what());
+    }
+}
+
+SubscriptionHandle::SubscriptionHandle(SubscriptionHandle&& other) noexcept
+    : m_group(std::move(other.m_group))
+    , m_subscriptionId(other.m_subscriptionId)
+{
+}
+
+SubscriptionHandle& SubscriptionHandle::operator=(SubscriptionHandle&& other) noexcept
+{
+    if (this != &other) {
+        auto previous = std::move(*this);
+        m_group = std::move(other.m_group);
+        m_subscriptionId = other.m_subscriptionId;
+    }
+    return *this;
+}
+
+/**
+ * Returns the sysrepo-level subscription ID of the callback.
+ */
+uint32_t SubscriptionHandle::subscriptionId() const
+{
+    return m_subscriptionId;
+}
+
+/**
+ * Unsubscribes the callback right away. Wraps `sr_unsubscribe_sub`.
+ *
+ * Once this returns, the callback is not running and it will not be called again. Calling this on a handle which has
+ * already been unsubscribed (or moved from) does nothing.
+ */
+void SubscriptionHandle::unsubscribe()
+{
+    if (!m_group) {
+        return;
+    }
+
+    auto group = std::move(m_group);
+    std::lock_guard lock{group->mtx};
+    group->sub.unsubscribe(m_subscriptionId);
+}
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <atomic>
+#include <mutex>
+extern "C" {
+#include <sysrepo.h>
+}
+#include <sysrepo-cpp/utils/exception.hpp>
+#include "utils/tracing.hpp"
+
+namespace sysrepo {
+namespace {
+struct TracerState {
+    // Checked first, so that the common case of no tracer at all does not need the mutex.
+    std::atomic<bool> enabled{false};
+    std::mutex mtx;
+    std::shared_ptr<const Tracer> tracer;
+};
+
+TracerState& tracerState()
+{
+    // Never destroyed, subscription threads might still be running callbacks while static objects are being destroyed.
+    static auto* state = new TracerState;
+    return *state;
+}
+
+std::shared_ptr<const Tracer> activeTracer()
+{
+    auto& state = tracerState();
+    if (!state.enabled.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+
+    std::lock_guard lock{state.mtx};
+    return state.tracer;
+}
+}
+
+/**
+ * @brief Installs a process-wide Tracer, or removes it when called with std::nullopt.
+ *
+ * Operations which are already in progress report the end of their spans to the Tracer which was active when they
+ * started.
+ */
+void setTracer(std::optional<Tracer> tracer)
+{
+    if (tracer && (!tracer->startSpan || !tracer->endSpan)) {
+        throw Error("setTracer: both startSpan and endSpan must be set");
+    }
+
+    auto& state = tracerState();
+    std::lock_guard lock{state.mtx};
+    state.tracer = tracer ? std::make_shared<const Tracer>(std::move(*tracer)) : nullptr;
+    state.enabled = !!state.tracer;
+}
+
+Span::Span(std::string_view operation, sr_session_ctx_s* sess, std::optional<std::string_view> target, std::optional<Event> event, std::optional<uint32_t> requestId)
+    : m_tracer(activeTracer())
+    , m_spanId(0)
+    , m_result(ErrorCode::OperationFailed)
+{
+    if (!m_tracer) {
+        return;
+    }
+
+    m_spanId = m_tracer->startSpan(SpanInfo{
+        .operation = operation,
+        .sessionId = sr_session_get_id(sess),
+        .target = target,
+        .event = event,
+        .requestId = requestId,
+        .traceId = getTraceId(sess),
+    });
+}
+
+Span::~Span()
+{
+    if (m_tracer) {
+        m_tracer->endSpan(m_spanId, m_result);
+    }
+}
+
+/**
+ * Sets the result which is reported at the end of this span. If this is not called, the span ends with
+ * ErrorCode::OperationFailed (which is what happens when an exception is thrown).
+ */
+void Span::setResult(int result)
+{
+    m_result = static_cast<ErrorCode>(result);
+}
+
+/**
+ * Looks for the trace ID in the originator data of a session. Internal use only.
+ */
+std::optional<std::string> getTraceId(sr_session_ctx_s* sess)
+{
+    for (uint32_t idx = 0;; ++idx) {
+        uint32_t size;
+        const void* data;
+        if (sr_session_get_orig_data(sess, idx, &size, &data) != SR_ERR_OK) {
+            return std::nullopt;
+        }
+
+        auto chunk = std::string_view{static_cast<const char*>(data), size};
+        if (chunk.starts_with(traceIdPrefix)) {
+            chunk.remove_prefix(traceIdPrefix.size());
+            return std::string{chunk};
+        }
+    }
+}
+}
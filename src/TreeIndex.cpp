@@ -0,0 +1,304 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <algorithm>
+#include <exception>
+#include <string_view>
+#include <sysrepo-cpp/TreeIndex.hpp>
+#include <sysrepo-cpp/utils/exception.hpp>
+#include <thread>
+extern "C" {
+#include <sysrepo.h>
+}
+
+namespace sysrepo {
+namespace {
+using Entries = std::vector<std::pair<std::string, size_t>>;
+
+/**
+ * Compares the magnitudes of two numbers in their canonical form, i.e., without a sign and without leading zeros. Once
+ * the integer parts have the same length, the string order is the numeric order.
+ */
+bool lessMagnitude(std::string_view a, std::string_view b)
+{
+    auto integerA = a.substr(0, a.find('.'));
+    auto integerB = b.substr(0, b.find('.'));
+    if (integerA.size() != integerB.size()) {
+        return integerA.size() < integerB.size();
+    }
+    return a < b;
+}
+
+/**
+ * Orders the values of a sorted index. Integers and decimal64 values are compared numerically, everything else as
+ * strings.
+ */
+struct ValueLess {
+    bool numeric;
+
+    bool operator()(const Entries::value_type& a, const Entries::value_type& b) const
+    {
+        if (!numeric) {
+            return a.first < b.first;
+        }
+
+        std::string_view x = a.first, y = b.first;
+        auto negativeX = x.starts_with('-'), negativeY = y.starts_with('-');
+        if (negativeX != negativeY) {
+            return negativeX;
+        }
+        if (negativeX) {
+            return lessMagnitude(y.substr(1), x.substr(1));
+        }
+        return lessMagnitude(x, y);
+    }
+};
+
+/**
+ * Whether the values of this leaf are integers or decimal64 numbers, including leafrefs to such leaves.
+ */
+bool isNumeric(const lysc_node* schema)
+{
+    if (!(schema->nodetype & LYD_NODE_TERM)) {
+        return false;
+    }
+
+    const auto* type = reinterpret_cast<const lysc_node_leaf*>(schema)->type;
+    if (type->basetype == LY_TYPE_LEAFREF) {
+        type = reinterpret_cast<const lysc_type_leafref*>(type)->realtype;
+    }
+
+    switch (type->basetype) {
+    case LY_TYPE_INT8:
+    case LY_TYPE_INT16:
+    case LY_TYPE_INT32:
+    case LY_TYPE_INT64:
+    case LY_TYPE_UINT8:
+    case LY_TYPE_UINT16:
+    case LY_TYPE_UINT32:
+    case LY_TYPE_UINT64:
+    case LY_TYPE_DEC64:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * Collects the values of `leafPath` in list instances [begin, end), along with the position of the instance. Instances
+ * without the leaf are skipped.
+ *
+ * This runs in several threads at once over the same tree, so it only uses the C API of libyang. The libyang-cpp
+ * wrappers update the shared reference tracking of the tree, which is not thread-safe.
+ */
+Entries collect(const std::vector<const lyd_node*>& instances, size_t begin, size_t end, const std::string& leafPath, const IndexKind kind, const ValueLess& less)
+{
+    Entries res;
+    res.reserve(end - begin);
+    for (auto i = begin; i < end; ++i) {
+        lyd_node* leaf;
+        auto err = lyd_find_path(instances[i], leafPath.c_str(), false, &leaf);
+        if (err == LY_ENOTFOUND || err == LY_EINCOMPLETE) {
+            continue;
+        }
+        if (err != LY_SUCCESS) {
+            throw Error{"TreeIndex: Couldn't look up \"" + leafPath + "\""};
+        }
+        if (!(leaf->schema->nodetype & LYD_NODE_TERM)) {
+            throw Error{"TreeIndex: \"" + leafPath + "\" is not a leaf"};
+        }
+        res.emplace_back(lyd_get_value(leaf), i);
+    }
+
+    if (kind == IndexKind::Sorted) {
+        // stable, so that instances with the same value keep their order from the data tree
+        std::stable_sort(res.begin(), res.end(), less);
+    }
+    return res;
+}
+}
+
+/**
+ * Prepares indexing of the list instances matching `listXPath`. The indexes themselves are built by
+ * TreeIndex::addIndex.
+ *
+ * @param tree The data tree. The index keeps it alive until TreeIndex::invalidate is called.
+ * @param listXPath An XPath selecting the list instances, e.g. `/ietf-interfaces:interfaces/interface`.
+ */
+TreeIndex::TreeIndex(libyang::DataNode tree, const std::string& listXPath)
+    : m_tree(tree)
+{
+    for (const auto& node : tree.findXPath(listXPath)) {
+        m_instances.emplace_back(node);
+    }
+}
+
+/**
+ * Builds an index on a leaf of the list instances. Building an index on a leaf which is already indexed replaces the
+ * previous index.
+ *
+ * @param leafPath Path to the indexed leaf, relative to the list instance, e.g. `if-index` or `config/address`.
+ * Instances which do not have this leaf are not indexed.
+ * @param kind What kind of index to build.
+ * @param parallelism How many threads to use for building the index. Only helps with large lists (thousands of
+ * instances).
+ */
+void TreeIndex::addIndex(const std::string& leafPath, const IndexKind kind, const unsigned parallelism)
+{
+    if (!isValid()) {
+        throw Error{"TreeIndex: the index has been invalidated"};
+    }
+
+    auto chunks = std::clamp<size_t>(parallelism, 1, std::max<size_t>(m_instances.size(), 1));
+    auto chunkSize = (m_instances.size() + chunks - 1) / chunks;
+    std::vector<const lyd_node*> instances;
+    instances.reserve(m_instances.size());
+    for (const auto& instance : m_instances) {
+        instances.emplace_back(libyang::getRawNode(instance));
+    }
+
+    auto less = ValueLess{.numeric = false};
+    if (kind == IndexKind::Sorted) {
+        for (const auto* instance : instances) {
+            lyd_node* leaf;
+            if (lyd_find_path(instance, leafPath.c_str(), false, &leaf) == LY_SUCCESS) {
+                less.numeric = isNumeric(leaf->schema);
+                break;
+            }
+        }
+    }
+
+    std::vector<Entries> parts(chunks);
+    std::vector<std::exception_ptr> errors(chunks);
+
+    auto work = [&](size_t i) {
+        try {
+            parts[i] = collect(instances, std::min(i * chunkSize, m_instances.size()), std::min((i + 1) * chunkSize, m_instances.size()), leafPath, kind, less);
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    };
+
+    {
+        std::vector<std::jthread> workers;
+        for (size_t i = 1; i < chunks; ++i) {
+            workers.emplace_back(work, i);
+        }
+        work(0);
+    }
+
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    Index index{.kind = kind, .numeric = less.numeric, .hashed = {}, .sorted = {}};
+    if (kind == IndexKind::Hash) {
+        index.hashed.reserve(m_instances.size());
+        for (auto& part : parts) {
+            for (auto& [value, position] : part) {
+                index.hashed.emplace(std::move(value), position);
+            }
+        }
+    } else {
+        for (auto& part : parts) {
+            auto middle = index.sorted.size();
+            index.sorted.insert(index.sorted.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+            std::inplace_merge(index.sorted.begin(), index.sorted.begin() + middle, index.sorted.end(), less);
+        }
+    }
+
+    m_indexes.insert_or_assign(leafPath, std::move(index));
+}
+
+const TreeIndex::Index& TreeIndex::index(const std::string& leafPath) const
+{
+    if (!isValid()) {
+        throw Error{"TreeIndex: the index has been invalidated"};
+    }
+
+    auto it = m_indexes.find(leafPath);
+    if (it == m_indexes.end()) {
+        throw Error{"TreeIndex: \"" + leafPath + "\" is not indexed"};
+    }
+    return it->second;
+}
+
+/**
+ * Returns the list instances whose leaf at `leafPath` has the given value, in the order of the data tree.
+ *
+ * @param leafPath The indexed leaf, as passed to TreeIndex::addIndex.
+ * @param value The canonical string form of the value.
+ */
+std::vector<libyang::DataNode> TreeIndex::find(const std::string& leafPath, const std::string& value) const
+{
+    const auto& idx = index(leafPath);
+    std::vector<size_t> positions;
+
+    if (idx.kind == IndexKind::Hash) {
+        auto [begin, end] = idx.hashed.equal_range(value);
+        for (auto it = begin; it != end; ++it) {
+            positions.emplace_back(it->second);
+        }
+        // unordered_multimap does not keep the insertion order of equal keys
+        std::sort(positions.begin(), positions.end());
+    } else {
+        auto [begin, end] = std::equal_range(idx.sorted.begin(), idx.sorted.end(), Entries::value_type{value, 0}, ValueLess{.numeric = idx.numeric});
+        for (auto it = begin; it != end; ++it) {
+            positions.emplace_back(it->second);
+        }
+    }
+
+    std::vector<libyang::DataNode> res;
+    res.reserve(positions.size());
+    for (auto position : positions) {
+        res.emplace_back(m_instances[position]);
+    }
+    return res;
+}
+
+/**
+ * Returns the list instances whose leaf at `leafPath` has a value in [from, to], ordered by that value. Only available
+ * for IndexKind::Sorted. Integers and decimal64 values are compared numerically, so `from` and `to` have to be in the
+ * canonical form of the leaf's type. All other values are compared as strings.
+ */
+std::vector<libyang::DataNode> TreeIndex::findRange(const std::string& leafPath, const std::string& from, const std::string& to) const
+{
+    const auto& idx = index(leafPath);
+    if (idx.kind != IndexKind::Sorted) {
+        throw Error{"TreeIndex: \"" + leafPath + "\" does not have a sorted index"};
+    }
+
+    std::vector<libyang::DataNode> res;
+    auto less = ValueLess{.numeric = idx.numeric};
+    auto begin = std::lower_bound(idx.sorted.begin(), idx.sorted.end(), Entries::value_type{from, 0}, less);
+    auto end = std::upper_bound(begin, idx.sorted.end(), Entries::value_type{to, 0}, less);
+    for (auto it = begin; it != end; ++it) {
+        res.emplace_back(m_instances[it->second]);
+    }
+
+    return res;
+}
+
+/**
+ * Drops all indexes and releases the data tree. Any further lookup throws.
+ */
+void TreeIndex::invalidate()
+{
+    m_indexes.clear();
+    m_instances.clear();
+    m_tree.reset();
+}
+
+/**
+ * Returns false once TreeIndex::invalidate has been called.
+ */
+bool TreeIndex::isValid() const
+{
+    return m_tree.has_value();
+}
+}
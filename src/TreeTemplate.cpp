@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <sysrepo-cpp/TreeTemplate.hpp>
+#include <sysrepo-cpp/utils/exception.hpp>
+extern "C" {
+#include <sysrepo.h>
+}
+
+namespace sysrepo {
+/**
+ * @param tree The complete tree with placeholder values, e.g. from libyang::Context::newPath. The template shares it
+ * rather than copying it.
+ */
+TreeTemplate::TreeTemplate(libyang::DataNode tree)
+    : m_tree(tree)
+{
+}
+
+/**
+ * Registers a leaf (or a leaf-list instance) whose value changes between the sends. Its current value becomes the
+ * placeholder restored by TreeTemplate::reset.
+ *
+ * @param path Path of the leaf, absolute or relative to the tree passed to the constructor.
+ */
+TreeTemplate::Slot TreeTemplate::slot(const std::string& path)
+{
+    auto node = m_tree.findPath(path);
+    if (!node || !node->isTerm()) {
+        throw Error{"TreeTemplate: \"" + path + "\" is not a leaf in the tree"};
+    }
+
+    m_leaves.emplace_back(libyang::getRawNode(*node));
+    m_placeholders.emplace_back(node->asTerm().valueStr());
+    m_changed.emplace_back(false);
+    return Slot{m_leaves.size() - 1};
+}
+
+/**
+ * Sets the value of a leaf. Wraps `lyd_change_term`.
+ */
+void TreeTemplate::set(const Slot slot, const std::string& value)
+{
+    auto res = lyd_change_term(m_leaves.at(slot.index), value.c_str());
+    // LY_EEXIST means that the value has not changed, LY_ENOT that only the default flag has
+    if (res != LY_SUCCESS && res != LY_EEXIST && res != LY_ENOT) {
+        throw Error{"TreeTemplate: Couldn't set value \"" + value + "\" (" + std::to_string(res) + ")"};
+    }
+    m_changed[slot.index] = true;
+}
+
+/**
+ * Puts the placeholder values back into all of the leaves which have been set since the last reset.
+ */
+void TreeTemplate::reset()
+{
+    for (size_t i = 0; i < m_leaves.size(); ++i) {
+        if (m_changed[i]) {
+            set(Slot{i}, m_placeholders[i]);
+            m_changed[i] = false;
+        }
+    }
+}
+
+/**
+ * Returns the tree, to be passed to Session::sendNotification or Session::sendRPC.
+ */
+libyang::DataNode TreeTemplate::tree() const
+{
+    return m_tree;
+}
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "coalesce.hpp"
+#include "utils.hpp"
+
+namespace sysrepo {
+/**
+ * Folds a change into a list of changes made by previous transactions, so that the result describes the difference
+ * between the state before the first transaction and after the last one. Internal use only.
+ */
+void mergeChange(std::vector<std::optional<ChangeRecord>>& records, std::map<std::string, size_t>& index, ChangeRecord&& change)
+{
+    auto it = index.find(change.path);
+    if (it == index.end() || !records[it->second]) {
+        index[change.path] = records.size();
+        records.emplace_back(std::move(change));
+        return;
+    }
+
+    auto& existing = records[it->second];
+    switch (existing->operation) {
+    case ChangeOperation::Created:
+        if (change.operation == ChangeOperation::Deleted) {
+            // It never existed as far as the user is concerned
+            existing.reset();
+            index.erase(it);
+        } else {
+            // Still a new node, just with a newer value or position
+            existing->value = change.value;
+            if (change.operation == ChangeOperation::Moved) {
+                existing->previousValue = change.previousValue;
+                existing->previousList = change.previousList;
+            }
+        }
+        return;
+    case ChangeOperation::Modified:
+        if (change.operation == ChangeOperation::Deleted) {
+            // The deleted value is the one before the window
+            existing->operation = ChangeOperation::Deleted;
+            existing->value = existing->previousValue;
+            existing->previousValue = std::nullopt;
+            existing->previousDefault = false;
+        } else {
+            existing->value = change.value;
+        }
+        if (existing->operation == ChangeOperation::Modified && existing->value == existing->previousValue) {
+            existing.reset();
+            index.erase(it);
+        }
+        return;
+    case ChangeOperation::Deleted:
+        if (change.operation == ChangeOperation::Created) {
+            if (!existing->value || existing->value == change.value) {
+                // Recreated as it was
+                existing.reset();
+                index.erase(it);
+            } else {
+                existing->operation = ChangeOperation::Modified;
+                existing->previousValue = existing->value;
+                existing->value = change.value;
+            }
+            return;
+        }
+        break;
+    case ChangeOperation::Moved:
+        if (change.operation == ChangeOperation::Moved) {
+            existing->previousValue = change.previousValue;
+            existing->previousList = change.previousList;
+            return;
+        }
+        break;
+    }
+
+    // Anything else simply supersedes the previous change, but it keeps its place in the order.
+    *existing = std::move(change);
+}
+
+ChangeCoalescer::ChangeCoalescer(const std::string& moduleName, CoalescedChangeCb cb, std::chrono::milliseconds window, std::shared_ptr<ExceptionHandler> exceptionHandler)
+    : m_moduleName(moduleName)
+    , m_cb(cb)
+    , m_window(window)
+    , m_exceptionHandler(exceptionHandler)
+    , m_thread([this] { run(); })
+{
+}
+
+/**
+ * Passes whatever is pending to the callback and stops the timer thread.
+ */
+ChangeCoalescer::~ChangeCoalescer()
+{
+    {
+        std::lock_guard lock{m_mtx};
+        m_stop = true;
+    }
+    m_cv.notify_one();
+    m_thread.join();
+}
+
+/**
+ * Adds changes of a single transaction. The first transaction after a flush starts the window.
+ */
+void ChangeCoalescer::add(uint32_t requestId, std::vector<ChangeRecord>&& changes)
+{
+    std::lock_guard lock{m_mtx};
+    for (auto& change : changes) {
+        mergeChange(m_records, m_index, std::move(change));
+    }
+    m_lastRequestId = requestId;
+    if (!m_deadline) {
+        m_deadline = std::chrono::steady_clock::now() + m_window;
+        m_cv.notify_one();
+    }
+}
+
+void ChangeCoalescer::run()
+{
+    std::unique_lock lock{m_mtx};
+    while (!m_stop) {
+        if (!m_deadline) {
+            m_cv.wait(lock);
+        } else if (m_cv.wait_until(lock, *m_deadline) == std::cv_status::timeout) {
+            flush(lock);
+        }
+    }
+
+    if (m_deadline) {
+        flush(lock);
+    }
+}
+
+void ChangeCoalescer::flush(std::unique_lock<std::mutex>& lock)
+{
+    ChangeSet set{.moduleName = m_moduleName, .requestId = m_lastRequestId, .changes = {}};
+    for (auto& record : m_records) {
+        if (record) {
+            set.changes.emplace_back(std::move(*record));
+        }
+    }
+    m_records.clear();
+    m_index.clear();
+    m_deadline = std::nullopt;
+
+    if (set.changes.empty()) {
+        return;
+    }
+
+    // New transactions can keep coming in while the callback runs, they will start a new window.
+    lock.unlock();
+    try {
+        m_cb(set);
+    } catch (std::exception& ex) {
+        handleExceptionFromCb(ex, m_exceptionHandler.get());
+    }
+    lock.lock();
+}
+}
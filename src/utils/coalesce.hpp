@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+#pragma once
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <sysrepo-cpp/Subscription.hpp>
+#include <thread>
+
+namespace sysrepo {
+void mergeChange(std::vector<std::optional<ChangeRecord>>& records, std::map<std::string, size_t>& index, ChangeRecord&& change);
+
+/**
+ * Collects changes of several transactions and passes them to the user callback once the window is over. Internal use
+ * only.
+ */
+class ChangeCoalescer {
+public:
+    ChangeCoalescer(const std::string& moduleName, CoalescedChangeCb cb, std::chrono::milliseconds window, std::shared_ptr<ExceptionHandler> exceptionHandler);
+    ~ChangeCoalescer();
+    ChangeCoalescer(const ChangeCoalescer&) = delete;
+    ChangeCoalescer& operator=(const ChangeCoalescer&) = delete;
+
+    void add(uint32_t requestId, std::vector<ChangeRecord>&& changes);
+
+private:
+    void run();
+    void flush(std::unique_lock<std::mutex>& lock);
+
+    const std::string m_moduleName;
+    const CoalescedChangeCb m_cb;
+    const std::chrono::milliseconds m_window;
+    const std::shared_ptr<ExceptionHandler> m_exceptionHandler;
+
+    std::mutex m_mtx;
+    std::condition_variable m_cv;
+    bool m_stop = false;
+    std::optional<std::chrono::steady_clock::time_point> m_deadline;
+    uint32_t m_lastRequestId = 0;
+    // Changes which cancelled out are left as std::nullopt, so that the index stays valid.
+    std::vector<std::optional<ChangeRecord>> m_records;
+    std::map<std::string, size_t> m_index;
+
+    std::thread m_thread;
+};
+}
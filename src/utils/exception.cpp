@@ -9,6 +9,7 @@
 #include <sysrepo.h>
 #include <sysrepo-cpp/Session.hpp>
 #include "exception.hpp"
+#include "stats.hpp"
 
 namespace sysrepo {
 ErrorWithCode::ErrorWithCode(const std::string& what, uint32_t errCode)
@@ -22,12 +23,11 @@ ErrorCode ErrorWithCode::code() const
     return m_errCode;
 }
 
-// TODO: Idea for improvement: (maybe) use std::source_location when Clang supports it
-void throwIfError(int code, const std::string& msg, sr_session_ctx_s *c_session)
+/**
+ * Builds the message of an error with the given code, including the errors reported by sysrepo for the session.
+ */
+std::string errorMessage(int code, const std::string& msg, sr_session_ctx_s *c_session)
 {
-    if (code == SR_ERR_OK)
-        return;
-
     std::ostringstream oss;
     oss << msg << ": " << static_cast<ErrorCode>(code);
     if (c_session) {
@@ -38,6 +38,19 @@ void throwIfError(int code, const std::string& msg, sr_session_ctx_s *c_session)
             oss << "\n NETCONF: " << err;
         }
     }
-    throw ErrorWithCode(oss.str(), code);
+    return oss.str();
+}
+
+// TODO: Idea for improvement: (maybe) use std::source_location when Clang supports it
+void throwIfError(int code, const std::string& msg, sr_session_ctx_s *c_session)
+{
+    if (code == SR_ERR_OK)
+        return;
+
+    if (static_cast<size_t>(code) < libraryCounters().errors.size()) {
+        libraryCounters().errors[code].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    throw ErrorWithCode(errorMessage(code, msg, c_session), code);
 }
 }
@@ -14,6 +14,7 @@ struct sr_session_ctx_s;
 
 namespace sysrepo {
     void throwIfError(int code, const std::string& msg, sr_session_ctx_s *c_session = nullptr);
+    std::string errorMessage(int code, const std::string& msg, sr_session_ctx_s *c_session = nullptr);
 
     template <typename ErrType>
     std::vector<ErrType> impl_getErrors(sr_session_ctx_s* sess);
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <latch>
+#include "pool.hpp"
+
+namespace sysrepo {
+WorkerPool::WorkerPool(unsigned threads)
+{
+    for (unsigned i = 0; i < threads; ++i) {
+        m_threads.emplace_back(&WorkerPool::run, this);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard lock{m_mtx};
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::run()
+{
+    std::unique_lock lock{m_mtx};
+    while (true) {
+        m_cv.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+        if (m_tasks.empty()) {
+            return;
+        }
+        auto task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+/**
+ * Runs all of the tasks and returns once they have finished. The calling thread takes part in the work, so this also
+ * works with a pool with no threads. The tasks must not throw.
+ */
+void WorkerPool::runAll(std::vector<std::function<void()>>& tasks)
+{
+    std::latch done{static_cast<std::ptrdiff_t>(tasks.size())};
+    {
+        std::lock_guard lock{m_mtx};
+        for (auto& task : tasks) {
+            m_tasks.emplace_back([&task, &done] {
+                task();
+                done.count_down();
+            });
+        }
+    }
+    m_cv.notify_all();
+
+    while (true) {
+        std::unique_lock lock{m_mtx};
+        if (m_tasks.empty()) {
+            break;
+        }
+        auto task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+        lock.unlock();
+        task();
+    }
+
+    done.wait();
+}
+}
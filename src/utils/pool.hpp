@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sysrepo {
+/**
+ * A fixed set of threads for running batches of tasks. Internal use only.
+ */
+class WorkerPool {
+public:
+    explicit WorkerPool(unsigned threads);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void runAll(std::vector<std::function<void()>>& tasks);
+
+private:
+    void run();
+
+    std::mutex m_mtx;
+    std::condition_variable m_cv;
+    bool m_stop = false;
+    std::deque<std::function<void()>> m_tasks;
+    std::vector<std::thread> m_threads;
+};
+}
@@ -0,0 +1,13 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include "probes.hpp"
+
+// The tracer finds the semaphores via the notes of the probes, and expects them in the .probes section
+#define SYSREPO_CPP_DEFINE_SEMAPHORE(name) __extension__ unsigned short sysrepo_cpp_##name##_semaphore __attribute__((unused)) __attribute__((section(".probes")));
+extern "C" {
+SYSREPO_CPP_PROBES(SYSREPO_CPP_DEFINE_SEMAPHORE)
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+#pragma once
+
+/*
+ * USDT (SystemTap-style) static tracepoints. These are only compiled in when building with -DWITH_USDT=ON. Each probe
+ * is a `nop` instruction which gets patched only when a tracer (e.g., bpftrace) attaches to it. Every probe also has a
+ * semaphore which the tracer increments while it is attached, and the arguments are only evaluated when it is nonzero.
+ *
+ * All probes belong to the `sysrepo_cpp` provider. String arguments are passed as `const char*`. A new probe has to be
+ * added to SYSREPO_CPP_PROBES, so that its semaphore is defined.
+ */
+#ifdef SYSREPO_CPP_USDT
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+#define SYSREPO_CPP_PROBES(X) \
+    X(set_item__entry) \
+    X(set_item__return) \
+    X(get_data__entry) \
+    X(get_data__return) \
+    X(apply_changes__entry) \
+    X(apply_changes__return) \
+    X(send_rpc__entry) \
+    X(send_rpc__return) \
+    X(send_notification__entry) \
+    X(send_notification__return) \
+    X(module_change__entry) \
+    X(module_change__return) \
+    X(oper_get__entry) \
+    X(oper_get__shed) \
+    X(oper_get__return) \
+    X(rpc_action__entry) \
+    X(rpc_action__return) \
+    X(notification__entry) \
+    X(notification__return)
+
+#define SYSREPO_CPP_DECLARE_SEMAPHORE(name) extern unsigned short sysrepo_cpp_##name##_semaphore;
+extern "C" {
+SYSREPO_CPP_PROBES(SYSREPO_CPP_DECLARE_SEMAPHORE)
+}
+#undef SYSREPO_CPP_DECLARE_SEMAPHORE
+
+#define SYSREPO_CPP_PROBE_ENABLED(name) __builtin_expect(sysrepo_cpp_##name##_semaphore != 0, 0)
+#define SYSREPO_CPP_PROBE(name, ...) do { if (SYSREPO_CPP_PROBE_ENABLED(name)) { STAP_PROBEV(sysrepo_cpp, name, __VA_ARGS__); } } while (false)
+#else
+#define SYSREPO_CPP_PROBE_ENABLED(name) false
+#define SYSREPO_CPP_PROBE(...) do { } while (false)
+#endif
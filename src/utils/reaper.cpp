@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "reaper.hpp"
+
+namespace sysrepo {
+namespace {
+/**
+ * A thread which destroys objects whose destructors would block for too long.
+ */
+struct Reaper {
+    Reaper()
+    {
+        std::thread{[this] { run(); }}.detach();
+    }
+
+    void run()
+    {
+        std::unique_lock lock{mtx};
+        while (true) {
+            wakeup.wait(lock, [this] { return !queue.empty(); });
+            auto garbage = std::move(queue.front());
+            queue.pop_front();
+            busy = true;
+            lock.unlock();
+
+            // This is where the actual (potentially slow) destructor runs
+            garbage.reset();
+
+            lock.lock();
+            busy = false;
+            if (queue.empty()) {
+                idle.notify_all();
+            }
+        }
+    }
+
+    std::mutex mtx;
+    std::condition_variable wakeup;
+    std::condition_variable idle;
+    std::deque<std::shared_ptr<void>> queue;
+    bool busy = false;
+};
+
+Reaper& reaper()
+{
+    // Never destroyed, the thread keeps running until the process exits.
+    static auto* reaper = new Reaper;
+    return *reaper;
+}
+}
+
+/**
+ * Drops a reference to `garbage` from a background thread. Internal use only.
+ */
+void reapInBackground(std::shared_ptr<void> garbage)
+{
+    auto& r = reaper();
+    {
+        std::lock_guard lock{r.mtx};
+        r.queue.emplace_back(std::move(garbage));
+    }
+    r.wakeup.notify_one();
+}
+
+/**
+ * Blocks until everything passed to reapInBackground so far has been dropped. Internal use only.
+ */
+void waitForReaper()
+{
+    auto& r = reaper();
+    std::unique_lock lock{r.mtx};
+    r.idle.wait(lock, [&r] { return r.queue.empty() && !r.busy; });
+}
+}
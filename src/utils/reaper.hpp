@@ -0,0 +1,13 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+#pragma once
+
+#include <memory>
+
+namespace sysrepo {
+void reapInBackground(std::shared_ptr<void> garbage);
+void waitForReaper();
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+
+#include <algorithm>
+#include <bit>
+#include "stats.hpp"
+
+namespace sysrepo {
+namespace {
+size_t latencyBucket(std::chrono::nanoseconds duration)
+{
+    auto us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    return std::min<size_t>(std::bit_width(us), LatencyHistogram::BucketCount - 1);
+}
+}
+
+void InvocationCounters::record(std::optional<ErrorCode> ret, bool threw, std::chrono::nanoseconds duration)
+{
+    // Relaxed ordering is enough, these are statistics and nobody synchronizes on them.
+    invocations.fetch_add(1, std::memory_order_relaxed);
+    if (threw) {
+        exceptions.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (ret && static_cast<size_t>(*ret) < errorCodes.size()) {
+        errorCodes[static_cast<size_t>(*ret)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    auto ns = static_cast<uint64_t>(std::max(duration.count(), decltype(duration.count()){0}));
+    buckets[latencyBucket(duration)].fetch_add(1, std::memory_order_relaxed);
+    totalNs.fetch_add(ns, std::memory_order_relaxed);
+    auto prevMax = maxNs.load(std::memory_order_relaxed);
+    while (prevMax < ns && !maxNs.compare_exchange_weak(prevMax, ns, std::memory_order_relaxed)) {
+    }
+}
+
+InvocationStats InvocationCounters::snapshot() const
+{
+    InvocationStats res{
+        .invocations = invocations.load(std::memory_order_relaxed),
+        .exceptions = exceptions.load(std::memory_order_relaxed),
+        .errorCodes = {},
+        .latency = {
+            .buckets = {},
+            .total = std::chrono::nanoseconds{totalNs.load(std::memory_order_relaxed)},
+            .max = std::chrono::nanoseconds{maxNs.load(std::memory_order_relaxed)},
+        },
+    };
+
+    for (size_t i = 0; i < errorCodes.size(); ++i) {
+        if (auto cnt = errorCodes[i].load(std::memory_order_relaxed)) {
+            res.errorCodes[static_cast<ErrorCode>(i)] = cnt;
+        }
+    }
+
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        res.latency.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+    }
+
+    return res;
+}
+
+CallbackCounters::CallbackCounters(CallbackType type, const std::string& name, const std::optional<std::string>& xpath)
+    : type(type)
+    , name(name)
+    , xpath(xpath)
+    , subscriptionId(0)
+{
+    auto& lib = libraryCounters();
+    std::lock_guard lock{lib.callbacksMtx};
+    lib.callbacks.insert(this);
+}
+
+CallbackCounters::~CallbackCounters()
+{
+    auto& lib = libraryCounters();
+    std::lock_guard lock{lib.callbacksMtx};
+    lib.callbacks.erase(this);
+}
+
+/**
+ * Records one invocation of the callback. The `event` is std::nullopt for callbacks which are not tied to a specific
+ * Event, and `ret` is std::nullopt for callbacks which do not return anything.
+ */
+void CallbackCounters::record(std::optional<Event> event, std::optional<ErrorCode> ret, bool threw, std::chrono::nanoseconds duration)
+{
+    if (event && static_cast<size_t>(*event) < perEvent.size()) {
+        perEvent[static_cast<size_t>(*event)].record(ret, threw, duration);
+    }
+    total.record(ret, threw, duration);
+}
+
+CallbackStats CallbackCounters::snapshot() const
+{
+    CallbackStats res{
+        .subscriptionId = subscriptionId.load(std::memory_order_relaxed),
+        .type = type,
+        .name = name,
+        .xpath = xpath,
+        .perEvent = {},
+        .total = total.snapshot(),
+        .shed = shedding.shed.load(std::memory_order_relaxed),
+    };
+
+    for (size_t i = 0; i < perEvent.size(); ++i) {
+        if (perEvent[i].invocations.load(std::memory_order_relaxed)) {
+            res.perEvent.emplace(static_cast<Event>(i), perEvent[i].snapshot());
+        }
+    }
+
+    return res;
+}
+
+void LoadShedder::configure(const std::optional<LoadSheddingPolicy>& policy)
+{
+    if (!policy) {
+        thresholdNs.store(0, std::memory_order_relaxed);
+        shedUntilNs.store(0, std::memory_order_relaxed);
+        return;
+    }
+
+    cooldownNs.store(std::chrono::nanoseconds{policy->cooldown}.count(), std::memory_order_relaxed);
+    thresholdNs.store(std::max<int64_t>(std::chrono::nanoseconds{policy->latencyThreshold}.count(), 1), std::memory_order_relaxed);
+}
+
+/**
+ * Returns true if a request should be answered without calling the user callback. Such requests are counted.
+ */
+bool LoadShedder::shouldShed(std::chrono::steady_clock::time_point now)
+{
+    if (!thresholdNs.load(std::memory_order_relaxed)
+        || std::chrono::nanoseconds{now.time_since_epoch()}.count() >= shedUntilNs.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    shed.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void LoadShedder::observe(std::chrono::nanoseconds duration, std::chrono::steady_clock::time_point now)
+{
+    auto threshold = thresholdNs.load(std::memory_order_relaxed);
+    if (threshold && duration.count() > threshold) {
+        auto until = std::chrono::nanoseconds{now.time_since_epoch()} + std::chrono::nanoseconds{cooldownNs.load(std::memory_order_relaxed)};
+        shedUntilNs.store(until.count(), std::memory_order_relaxed);
+    }
+}
+
+LibraryCounters& libraryCounters()
+{
+    // Never destroyed, so that it can be safely used from destructors of static objects.
+    static auto* counters = new LibraryCounters;
+    return *counters;
+}
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <sysrepo-cpp/Statistics.hpp>
+
+namespace sysrepo {
+/**
+ * Lock-free counterpart of InvocationStats. The trampolines update these from the subscription thread while the user
+ * might be reading them from another one. Internal use only.
+ */
+struct InvocationCounters {
+    void record(std::optional<ErrorCode> ret, bool threw, std::chrono::nanoseconds duration);
+    InvocationStats snapshot() const;
+
+    std::atomic<uint64_t> invocations{0};
+    std::atomic<uint64_t> exceptions{0};
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(ErrorCode::CallbackShelve) + 1> errorCodes{};
+    std::array<std::atomic<uint64_t>, LatencyHistogram::BucketCount> buckets{};
+    std::atomic<uint64_t> totalNs{0};
+    std::atomic<uint64_t> maxNs{0};
+};
+
+/**
+ * State of the load shedding of an operational callback, see Subscription::setLoadShedding. Internal use only.
+ */
+struct LoadShedder {
+    void configure(const std::optional<LoadSheddingPolicy>& policy);
+    bool shouldShed(std::chrono::steady_clock::time_point now);
+    void observe(std::chrono::nanoseconds duration, std::chrono::steady_clock::time_point now);
+
+    // Zero means that shedding is disabled.
+    std::atomic<int64_t> thresholdNs{0};
+    std::atomic<int64_t> cooldownNs{0};
+    // A steady_clock time point, in nanoseconds since its epoch.
+    std::atomic<int64_t> shedUntilNs{0};
+    std::atomic<uint64_t> shed{0};
+};
+
+/**
+ * Runtime counters of a single callback, shared between the PrivData and the Subscription. Internal use only.
+ */
+struct CallbackCounters {
+    CallbackCounters(CallbackType type, const std::string& name, const std::optional<std::string>& xpath);
+    ~CallbackCounters();
+    CallbackCounters(const CallbackCounters&) = delete;
+    CallbackCounters& operator=(const CallbackCounters&) = delete;
+
+    void record(std::optional<Event> event, std::optional<ErrorCode> ret, bool threw, std::chrono::nanoseconds duration);
+    CallbackStats snapshot() const;
+
+    const CallbackType type;
+    const std::string name;
+    const std::optional<std::string> xpath;
+    // Set by the first invocation (which can happen while subscribing, e.g., with SubscribeOptions::Enabled) or once the
+    // subscription has been made, whichever comes first. Zero until then, while the counters are already visible in
+    // LibraryCounters::callbacks.
+    std::atomic<uint32_t> subscriptionId;
+    std::array<InvocationCounters, static_cast<size_t>(Event::RPC) + 1> perEvent;
+    InvocationCounters total;
+    LoadShedder shedding;
+};
+
+/**
+ * Process-wide counters of the whole library. Internal use only.
+ */
+struct LibraryCounters {
+    std::atomic<uint64_t> sessionsCreated{0};
+    std::atomic<uint64_t> subscriptionsAlive{0};
+    std::atomic<uint64_t> outstandingData{0};
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(ErrorCode::CallbackShelve) + 1> errors{};
+
+    // All callbacks which currently exist, no matter which Subscription they belong to.
+    std::mutex callbacksMtx;
+    std::set<const CallbackCounters*> callbacks;
+};
+
+LibraryCounters& libraryCounters();
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+*/
+#pragma once
+
+#include <memory>
+#include <sysrepo-cpp/Tracing.hpp>
+
+struct sr_session_ctx_s;
+
+namespace sysrepo {
+/**
+ * Marks the chunk of originator data which carries the trace ID.
+ */
+constexpr std::string_view traceIdPrefix = "sysrepo-cpp:trace-id=";
+
+/**
+ * RAII wrapper which reports a span to the installed Tracer (if any). Internal use only.
+ *
+ * When no Tracer is installed, this costs one relaxed atomic load.
+ */
+class Span {
+public:
+    Span(std::string_view operation, sr_session_ctx_s* sess, std::optional<std::string_view> target, std::optional<Event> event = std::nullopt, std::optional<uint32_t> requestId = std::nullopt);
+    ~Span();
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    void setResult(int result);
+
+private:
+    std::shared_ptr<const Tracer> m_tracer;
+    uint64_t m_spanId;
+    ErrorCode m_result;
+};
+
+std::optional<std::string> getTraceId(sr_session_ctx_s* sess);
+}
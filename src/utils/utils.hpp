@@ -14,4 +14,7 @@ namespace sysrepo {
 std::timespec toTimespec(std::chrono::time_point<std::chrono::system_clock, std::chrono::nanoseconds>);
 std::chrono::time_point<std::chrono::system_clock, std::chrono::nanoseconds> toTimePoint(std::timespec ts);
 void checkNoThreadFlag(const SubscribeOptions opts, const std::optional<FDHandling>& callbacks);
+ChangeRecord toChangeRecord(const Change& change);
+std::string subtreeXPath(const std::optional<std::string>& xpath);
+void handleExceptionFromCb(std::exception& ex, ExceptionHandler* exceptionHandler);
 }
@@ -9,6 +9,7 @@
 #include <doctest/doctest.h>
 #include <optional>
 #include <sysrepo-cpp/Connection.hpp>
+#include <sysrepo-cpp/TreeIndex.hpp>
 #include <sysrepo-cpp/utils/utils.hpp>
 #include <sysrepo-cpp/utils/exception.hpp>
 
@@ -488,4 +489,60 @@ TEST_CASE("session")
         REQUIRE(s.enabled);
         REQUIRE(s.earliestNotification);
     }
+    DOCTEST_SUBCASE("secondary indexes")
+    {
+        sess.setItem("/test_module:popelnice/content/trash[name='a']/cont/l", "x");
+        sess.setItem("/test_module:popelnice/content/trash[name='b']/cont/l", "y");
+        sess.setItem("/test_module:popelnice/content/trash[name='c']/cont/l", "x");
+        sess.setItem("/test_module:popelnice/content/trash[name='d']", std::nullopt);
+        sess.applyChanges();
+
+        auto names = [](const std::vector<libyang::DataNode>& nodes) {
+            std::vector<std::string> res;
+            for (const auto& node : nodes) {
+                res.emplace_back(node.findPath("name")->asTerm().valueStr());
+            }
+            return res;
+        };
+
+        sysrepo::TreeIndex index{*sess.getData("/test_module:popelnice"), "/test_module:popelnice/content/trash"};
+        REQUIRE_THROWS_WITH_AS(index.find("cont/l", "x"), "TreeIndex: \"cont/l\" is not indexed", sysrepo::Error);
+
+        DOCTEST_SUBCASE("hash")
+        {
+            index.addIndex("cont/l", sysrepo::IndexKind::Hash, 3);
+            REQUIRE(names(index.find("cont/l", "x")) == std::vector<std::string>{"a", "c"});
+            REQUIRE(names(index.find("cont/l", "y")) == std::vector<std::string>{"b"});
+            REQUIRE(index.find("cont/l", "z").empty());
+            REQUIRE_THROWS_WITH_AS(index.findRange("cont/l", "a", "z"), "TreeIndex: \"cont/l\" does not have a sorted index", sysrepo::Error);
+        }
+
+        DOCTEST_SUBCASE("sorted")
+        {
+            index.addIndex("cont/l", sysrepo::IndexKind::Sorted, 3);
+            REQUIRE(names(index.find("cont/l", "x")) == std::vector<std::string>{"a", "c"});
+            REQUIRE(names(index.findRange("cont/l", "a", "z")) == std::vector<std::string>{"a", "c", "b"});
+            REQUIRE(names(index.findRange("cont/l", "y", "z")) == std::vector<std::string>{"b"});
+        }
+
+        DOCTEST_SUBCASE("sorted numerically")
+        {
+            sess.setItem("/test_module:popelnice/content/trash[name='a']/weight", "10");
+            sess.setItem("/test_module:popelnice/content/trash[name='b']/weight", "9");
+            sess.setItem("/test_module:popelnice/content/trash[name='c']/weight", "-20");
+            sess.setItem("/test_module:popelnice/content/trash[name='d']/weight", "-3");
+            sess.applyChanges();
+            index = sysrepo::TreeIndex{*sess.getData("/test_module:popelnice"), "/test_module:popelnice/content/trash"};
+            index.addIndex("weight", sysrepo::IndexKind::Sorted, 2);
+            REQUIRE(names(index.findRange("weight", "-100", "100")) == std::vector<std::string>{"c", "d", "b", "a"});
+            REQUIRE(names(index.findRange("weight", "-5", "9")) == std::vector<std::string>{"d", "b"});
+            REQUIRE(names(index.find("weight", "10")) == std::vector<std::string>{"a"});
+        }
+
+        REQUIRE_THROWS_WITH_AS(index.addIndex("cont"), "TreeIndex: \"cont\" is not a leaf", sysrepo::Error);
+        REQUIRE(index.isValid());
+        index.invalidate();
+        REQUIRE(!index.isValid());
+        REQUIRE_THROWS_WITH_AS(index.find("cont/l", "x"), "TreeIndex: the index has been invalidated", sysrepo::Error);
+    }
 }
@@ -6,14 +6,31 @@
  * SPDX-License-Identifier: BSD-3-Clause
 */
 
+#include <array>
 #include <atomic>
 #include <doctest/doctest.h>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
 #include <pretty_printers.hpp>
 #include <sysrepo-cpp/Connection.hpp>
+#include <sysrepo-cpp/MaterializedView.hpp>
+#include <sysrepo-cpp/NotificationStore.hpp>
+#include <sysrepo-cpp/NotificationThrottle.hpp>
+#include <sysrepo-cpp/OutputBuilder.hpp>
+#include <sysrepo-cpp/RequestXPath.hpp>
+#include <sysrepo-cpp/Router.hpp>
+#include <sysrepo-cpp/Statistics.hpp>
+#include <sysrepo-cpp/SubscriptionGroup.hpp>
+#include <sysrepo-cpp/TreeTemplate.hpp>
+#include <sysrepo-cpp/Tracing.hpp>
 #include <sysrepo-cpp/utils/utils.hpp>
 #include <sysrepo-cpp/utils/exception.hpp>
+#include <sysrepo-cpp/utils/queue.hpp>
 #include <thread>
 #include <trompeloeil.hpp>
+#include <poll.h>
 #include <unistd.h>
 #include "utils.hpp"
 
@@ -53,6 +70,85 @@ void write_something(int fd)
     REQUIRE(write(fd, ".", 1) == 1);
 }
 
+/** @short A poll()-based event loop in its own thread, watching any number of FDs */
+class EventLoop {
+public:
+    EventLoop()
+    {
+        REQUIRE(pipe(m_control) == 0);
+        m_thread = std::thread{[this] { run(); }};
+    }
+
+    ~EventLoop()
+    {
+        m_quit = true;
+        write_something(m_control[1]);
+        m_thread.join();
+        close(m_control[0]);
+        close(m_control[1]);
+    }
+
+    sysrepo::FDHandling handling()
+    {
+        return {
+            .registerFd = [this] (int fd, std::function<void()> processEvents) {
+                {
+                    std::lock_guard lock{m_mtx};
+                    m_handlers.emplace(fd, processEvents);
+                }
+                write_something(m_control[1]);
+            },
+            .unregisterFd = [this] (int fd) {
+                {
+                    std::lock_guard lock{m_mtx};
+                    m_handlers.erase(fd);
+                }
+                write_something(m_control[1]);
+            },
+        };
+    }
+
+private:
+    void run()
+    {
+        while (!m_quit) {
+            std::vector<pollfd> fds{{.fd = m_control[0], .events = POLLIN, .revents = 0}};
+            {
+                std::lock_guard lock{m_mtx};
+                for (const auto& [fd, handler] : m_handlers) {
+                    fds.push_back({.fd = fd, .events = POLLIN, .revents = 0});
+                }
+            }
+            if (poll(fds.data(), fds.size(), -1) == -1) {
+                throw std::runtime_error("poll() failed");
+            }
+            if (fds.front().revents & POLLIN) {
+                read_something(m_control[0]);
+            }
+            for (auto it = fds.begin() + 1; it != fds.end(); ++it) {
+                if (!(it->revents & POLLIN)) {
+                    continue;
+                }
+                std::function<void()> handler;
+                {
+                    std::lock_guard lock{m_mtx};
+                    if (auto found = m_handlers.find(it->fd); found != m_handlers.end()) {
+                        handler = found->second;
+                    }
+                }
+                if (handler) {
+                    handler();
+                }
+            }
+        }
+    }
+
+    int m_control[2];
+    std::mutex m_mtx;
+    std::map<int, std::function<void()>> m_handlers;
+    std::atomic<bool> m_quit = false;
+    std::thread m_thread;
+};
 }
 
 TEST_CASE("subscriptions")
@@ -80,6 +176,760 @@ TEST_CASE("subscriptions")
 
     }
 
+    DOCTEST_SUBCASE("callback statistics")
+    {
+        sysrepo::ModuleChangeCb moduleChangeCb = [&called] (auto, auto, auto, auto, auto event, auto) -> sysrepo::ErrorCode {
+            called++;
+            if (event == sysrepo::Event::Change && called == 1) {
+                throw std::runtime_error("Test callback throw");
+            }
+            return sysrepo::ErrorCode::Ok;
+        };
+
+        auto sub = sess.onModuleChange("test_module", moduleChangeCb, std::nullopt, 0, sysrepo::SubscribeOptions::Default, [] (std::exception&) {});
+        sub.onRPCAction("/test_module:noop", [] (auto, auto, auto, auto, auto, auto, auto) { return sysrepo::ErrorCode::Ok; });
+
+        auto stats = sub.stats();
+        REQUIRE(stats.size() == 2);
+        REQUIRE(stats[0].type == sysrepo::CallbackType::ModuleChange);
+        REQUIRE(stats[0].name == "test_module");
+        REQUIRE(stats[0].total.invocations == 0);
+        REQUIRE(stats[1].type == sysrepo::CallbackType::RPCAction);
+        REQUIRE(stats[1].name == "/test_module:noop");
+        REQUIRE(stats[0].subscriptionId != stats[1].subscriptionId);
+
+        sess.setItem("/test_module:leafInt32", "123");
+        REQUIRE_THROWS_AS(sess.applyChanges(), sysrepo::ErrorWithCode);
+        sess.applyChanges();
+        sess.sendRPC(sess.getContext().newPath("/test_module:noop"));
+
+        stats = sub.stats();
+        REQUIRE(stats[0].total.invocations == 3);
+        REQUIRE(stats[0].total.exceptions == 1);
+        REQUIRE(stats[0].perEvent.at(sysrepo::Event::Change).invocations == 2);
+        REQUIRE(stats[0].perEvent.at(sysrepo::Event::Change).errorCodes.at(sysrepo::ErrorCode::OperationFailed) == 1);
+        REQUIRE(stats[0].perEvent.at(sysrepo::Event::Done).errorCodes.at(sysrepo::ErrorCode::Ok) == 1);
+        REQUIRE(!stats[0].perEvent.contains(sysrepo::Event::Abort));
+        REQUIRE(stats[1].perEvent.at(sysrepo::Event::RPC).invocations == 1);
+
+        uint64_t inHistogram = 0;
+        for (auto bucket : stats[0].total.latency.buckets) {
+            inHistogram += bucket;
+        }
+        REQUIRE(inHistogram == 3);
+        REQUIRE(stats[0].total.latency.max <= stats[0].total.latency.total);
+    }
+
+    DOCTEST_SUBCASE("statistics of the initial delivery")
+    {
+        std::optional<uint32_t> reportedId;
+        auto sub = sess.onModuleChange("test_module", [&reportedId] (auto, uint32_t subscriptionId, auto, auto, auto event, auto) {
+            if (event == sysrepo::Event::Enabled) {
+                for (const auto& callback : sysrepo::libraryStats().callbacks) {
+                    if (callback.subscriptionId == subscriptionId) {
+                        reportedId = callback.subscriptionId;
+                    }
+                }
+            }
+            return sysrepo::ErrorCode::Ok;
+        }, std::nullopt, 0, sysrepo::SubscribeOptions::Enabled);
+        REQUIRE(reportedId == sub.stats().front().subscriptionId);
+        REQUIRE(sub.stats().front().perEvent.at(sysrepo::Event::Enabled).invocations == 1);
+    }
+
+    DOCTEST_SUBCASE("library statistics")
+    {
+        auto before = sysrepo::libraryStats();
+        auto sub = sess.onModuleChange("test_module", [] (auto, auto, auto, auto, auto, auto) { return sysrepo::ErrorCode::Ok; });
+        REQUIRE(sysrepo::libraryStats().subscriptionsAlive == before.subscriptionsAlive + 1);
+        REQUIRE(sysrepo::libraryStats().callbacks.size() == before.callbacks.size() + 1);
+
+        {
+            auto data = sess.getData("/test_module:leafInt32");
+            sess.setItem("/test_module:leafInt32", "123");
+            sess.applyChanges();
+            data = sess.getData("/test_module:leafInt32");
+            REQUIRE(sysrepo::libraryStats().outstandingData == before.outstandingData + 1);
+        }
+        REQUIRE(sysrepo::libraryStats().outstandingData == before.outstandingData);
+
+        REQUIRE_THROWS_AS(sess.getOneNode("/test_module:popelnice"), sysrepo::ErrorWithCode);
+        REQUIRE(sysrepo::libraryStats().errors.at(sysrepo::ErrorCode::NotFound) > before.errors[sysrepo::ErrorCode::NotFound]);
+
+        auto statsSub = sysrepo::publishLibraryStats(sess);
+        auto processPath = "/sysrepo-cpp-stats:sysrepo-cpp/process[pid='" + std::to_string(getpid()) + "']";
+        sess.switchDatastore(sysrepo::Datastore::Operational);
+        auto data = sess.getData(processPath);
+        REQUIRE(data);
+        REQUIRE(data->findPath(processPath + "/sessions-created"));
+        REQUIRE(data->findPath(processPath + "/subscriptions-alive")->asTerm().valueStr() == std::to_string(before.subscriptionsAlive + 2));
+        REQUIRE(data->findPath(processPath + "/callback[subscription-id='" + std::to_string(sub.stats().front().subscriptionId) + "']/event[name='done']/invocations")->asTerm().valueStr() == "1");
+    }
+
+    DOCTEST_SUBCASE("unsubscribing a single callback")
+    {
+        std::atomic<int> calledOther = 0;
+        auto sub = sess.onModuleChange("test_module", [&called] (auto, auto, auto, auto, auto, auto) {
+            called++;
+            return sysrepo::ErrorCode::Ok;
+        }, std::nullopt, 0, sysrepo::SubscribeOptions::DoneOnly);
+        auto firstId = sub.stats().front().subscriptionId;
+
+        for (int i = 0; i < 40; i++) {
+            sub.onModuleChange("test_module", [&calledOther] (auto, auto, auto, auto, auto, auto) {
+                calledOther++;
+                return sysrepo::ErrorCode::Ok;
+            }, std::nullopt, 0, sysrepo::SubscribeOptions::DoneOnly);
+            sub.unsubscribe(sub.stats().back().subscriptionId);
+        }
+        REQUIRE(sub.stats().size() == 1);
+
+        sub.onModuleChange("test_module", [&calledOther] (auto, auto, auto, auto, auto, auto) {
+            calledOther++;
+            return sysrepo::ErrorCode::Ok;
+        }, std::nullopt, 0, sysrepo::SubscribeOptions::DoneOnly);
+        sub.unsubscribe(firstId);
+        REQUIRE(sub.stats().size() == 1);
+        REQUIRE_THROWS_WITH_AS(sub.unsubscribe(firstId), ("Subscription::unsubscribe: no callback with ID " + std::to_string(firstId)).c_str(), sysrepo::Error);
+
+        sess.setItem("/test_module:leafInt32", "123");
+        sess.applyChanges();
+        REQUIRE(called == 0);
+        REQUIRE(calledOther == 1);
+    }
+
+    DOCTEST_SUBCASE("suspend and resume")
+    {
+        auto sub = sess.onModuleChange("test_module", [&called] (auto, auto, auto, auto, auto, auto) {
+            called++;
+            return sysrepo::ErrorCode::Ok;
+        }, std::nullopt, 0, sysrepo::SubscribeOptions::DoneOnly);
+        auto id = sub.stats().front().subscriptionId;
+        REQUIRE(!sub.isSuspended(id));
+
+        DOCTEST_SUBCASE("explicit")
+        {
+            sub.suspend(id);
+            REQUIRE(sub.isSuspended(id));
+            sess.setItem("/test_module:leafInt32", "123");
+            sess.applyChanges();
+            REQUIRE(called == 0);
+            sub.resume(id);
+        }
+
+        DOCTEST_SUBCASE("scoped")
+        {
+            {
+                auto guard = sub.suspendScoped(id);
+                REQUIRE(sub.isSuspended(id));
+                sess.setItem("/test_module:leafInt32", "123");
+                sess.applyChanges();
+                REQUIRE(called == 0);
+            }
+        }
+
+        REQUIRE(!sub.isSuspended(id));
+        sess.setItem("/test_module:leafInt32", "124");
+        sess.applyChanges();
+        REQUIRE(called == 1);
+    }
+
+    DOCTEST_SUBCASE("suspend guard outliving its subscription")
+    {
+        auto before = sysrepo::libraryStats().subscriptionsAlive;
+        std::optional<sysrepo::Subscription> sub = sess.onModuleChange("test_module", [&called] (auto, auto, auto, auto, auto, auto) {
+            called++;
+            return sysrepo::ErrorCode::Ok;
+        });
+        std::optional<sysrepo::SuspendGuard> guard = sub->suspendScoped(sub->stats().front().subscriptionId);
+
+        // the guard does not keep the subscription alive, and resuming it afterwards does nothing
+        sub.reset();
+        REQUIRE(sysrepo::libraryStats().subscriptionsAlive == before);
+        guard.reset();
+
+        sess.setItem("/test_module:leafInt32", "123");
+        sess.applyChanges();
+        REQUIRE(called == 0);
+    }
+
+    DOCTEST_SUBCASE("load shedding")
+    {
+        auto sub = sess.onOperGet("test_module", [&called] (auto session, auto, auto, auto, auto, auto, auto& parent) {
+            if (called++ == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds{50});
+            }
+            parent = session.getContext().newPath("/test_module:stateLeaf", "123");
+            return sysrepo::ErrorCode::Ok;
+        }, "/test_module:stateLeaf");
+        auto id = sub.stats().front().subscriptionId;
+        sub.setLoadShedding(id, sysrepo::LoadSheddingPolicy{.latencyThreshold = std::chrono::milliseconds{10}, .cooldown = std::chrono::hours{1}});
+        sess.switchDatastore(sysrepo::Datastore::Operational);
+
+        REQUIRE(sess.getData("/test_module:stateLeaf"));
+        REQUIRE(called == 1);
+        REQUIRE(sess.getData("/test_module:stateLeaf") == std::nullopt);
+        REQUIRE(called == 1);
+        REQUIRE(sub.stats().front().shed == 1);
+        REQUIRE(sub.stats().front().total.invocations == 1);
+
+        sub.setLoadShedding(id, std::nullopt);
+        REQUIRE(sess.getData("/test_module:stateLeaf"));
+        REQUIRE(called == 2);
+
+        REQUIRE_THROWS_AS(sub.setLoadShedding(id + 1000, std::nullopt), sysrepo::Error);
+    }
+
+    DOCTEST_SUBCASE("background teardown")
+    {
+        auto before = sysrepo::libraryStats();
+        std::vector<sysrepo::Subscription> subs;
+        for (int i = 0; i < 5; i++) {
+            subs.emplace_back(sess.onModuleChange("test_module", [&called] (auto, auto, auto, auto, auto, auto) {
+                called++;
+                return sysrepo::ErrorCode::Ok;
+            }));
+        }
+        REQUIRE(sysrepo::libraryStats().subscriptionsAlive == before.subscriptionsAlive + 5);
+
+        DOCTEST_SUBCASE("async destructor")
+        {
+            for (auto& sub : subs) {
+                sub.setAsyncTeardown(true);
+            }
+            subs.clear();
+            sysrepo::waitForBackgroundTeardown();
+        }
+
+        DOCTEST_SUBCASE("unsubscribeAll")
+        {
+            subs.front().setAsyncTeardown(true);
+            sysrepo::unsubscribeAll(std::move(subs), 2);
+        }
+
+        REQUIRE(sysrepo::libraryStats().subscriptionsAlive == before.subscriptionsAlive);
+        REQUIRE(sysrepo::libraryStats().callbacks.size() == before.callbacks.size());
+        sess.setItem("/test_module:leafInt32", "123");
+        sess.applyChanges();
+        REQUIRE(called == 0);
+    }
+
+    DOCTEST_SUBCASE("asynchronous module change")
+    {
+        EventLoop loop;
+        std::mutex workersMtx;
+        std::vector<std::thread> workers;
+        sysrepo::ErrorCode result = sysrepo::ErrorCode::Ok;
+        bool completeRightAway = false;
+        auto sub = sess.onModuleChangeAsync("test_module", [&] (auto, auto, auto, auto, auto event, auto, sysrepo::ChangeCompletion completion) {
+            called++;
+            auto ret = event == sysrepo::Event::Change ? result : sysrepo::ErrorCode::Ok;
+            if (completeRightAway) {
+                completion.complete(ret);
+                return;
+            }
+            std::lock_guard lock{workersMtx};
+            workers.emplace_back([completion, ret] () mutable {
+                std::this_thread::sleep_for(std::chrono::milliseconds{10});
+                completion.complete(ret);
+            });
+        }, std::nullopt, 0, sysrepo::SubscribeOptions::NoThread, nullptr, loop.handling());
+
+        sess.setItem("/test_module:leafInt32", "123");
+
+        DOCTEST_SUBCASE("completed later")
+        {
+            sess.applyChanges();
+            REQUIRE(called == 2);
+        }
+
+        DOCTEST_SUBCASE("completed within the callback")
+        {
+            completeRightAway = true;
+            sess.applyChanges();
+            REQUIRE(called == 2);
+        }
+
+        DOCTEST_SUBCASE("failure")
+        {
+            result = sysrepo::ErrorCode::OperationFailed;
+            REQUIRE_THROWS_AS(sess.applyChanges(), sysrepo::ErrorWithCode);
+            sess.discardChanges();
+        }
+
+        REQUIRE(sub.stats().front().total.errorCodes.contains(sysrepo::ErrorCode::CallbackShelve) == !completeRightAway);
+        std::lock_guard lock{workersMtx};
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    DOCTEST_SUBCASE("asynchronous module change requires a custom event loop")
+    {
+        REQUIRE_THROWS_WITH_AS(sess.onModuleChangeAsync("test_module", [] (auto, auto, auto, auto, auto, auto, auto) {}),
+                "Subscription::onModuleChangeAsync: a custom event loop (FDHandling) is required",
+                sysrepo::Error);
+    }
+
+    DOCTEST_SUBCASE("asynchronous module change with the initial data")
+    {
+        EventLoop loop;
+        std::mutex mtx;
+        std::vector<std::thread> workers;
+        std::vector<sysrepo::Event> events;
+        auto sub = sess.onModuleChangeAsync("test_module", [&] (auto, auto, auto, auto, auto event, auto, sysrepo::ChangeCompletion completion) {
+            std::lock_guard lock{mtx};
+            events.emplace_back(event);
+            workers.emplace_back([completion] () mutable {
+                std::this_thread::sleep_for(std::chrono::milliseconds{10});
+                completion.complete(sysrepo::ErrorCode::Ok);
+            });
+        }, std::nullopt, 0, sysrepo::SubscribeOptions::Enabled | sysrepo::SubscribeOptions::NoThread, nullptr, loop.handling());
+        {
+            // the initial events cannot be shelved, the subscribing waits for them instead
+            std::lock_guard lock{mtx};
+            REQUIRE(events == std::vector{sysrepo::Event::Enabled, sysrepo::Event::Done});
+        }
+
+        sess.setItem("/test_module:leafInt32", "123");
+        sess.applyChanges();
+
+        std::lock_guard lock{mtx};
+        REQUIRE(events == std::vector{sysrepo::Event::Enabled, sysrepo::Event::Done, sysrepo::Event::Change, sysrepo::Event::Done});
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    DOCTEST_SUBCASE("deferred Done processing")
+    {
+        auto queue = std::make_shared<sysrepo::ChangeQueue>(2);
+        auto sub = sess.onModuleChange("test_module", [] (auto, auto, auto, auto, auto, auto) { return sysrepo::ErrorCode::Ok; });
+        sub.onModuleChangeDeferred("test_module", queue);
+
+        sess.setItem("/test_module:leafInt32", "123");
+        sess.applyChanges();
+        sess.setItem("/test_module:leafInt32", "124");
+        sess.applyChanges();
+        sess.deleteItem("/test_module:leafInt32");
+        std::thread writer{[&sess] { sess.applyChanges(); }};
+
+        auto first = queue->pop();
+        REQUIRE(first.moduleName == "test_module");
+        REQUIRE(first.changes == std::vector<sysrepo::ChangeRecord>{
+            {sysrepo::ChangeOperation::Created, "/test_module:leafInt32", "123", std::nullopt, std::nullopt, false},
+        });
+        REQUIRE(queue->pop().changes == std::vector<sysrepo::ChangeRecord>{
+            {sysrepo::ChangeOperation::Modified, "/test_module:leafInt32", "124", "123", std::nullopt, false},
+        });
+        REQUIRE(queue->pop().changes == std::vector<sysrepo::ChangeRecord>{
+            {sysrepo::ChangeOperation::Deleted, "/test_module:leafInt32", "124", std::nullopt, std::nullopt, false},
+        });
+        writer.join();
+        REQUIRE(!queue->tryPop());
+    }
+
+    DOCTEST_SUBCASE("deferred Done processing with a union filter")
+    {
+        auto queue = std::make_shared<sysrepo::ChangeQueue>(1);
+        auto sub = sess.onModuleChange("test_module", [] (auto, auto, auto, auto, auto, auto) { return sysrepo::ErrorCode::Ok; });
+        sub.onModuleChangeDeferred("test_module", queue, "/test_module:popelnice | /test_module:leafInt32");
+
+        sess.setItem("/test_module:leafInt32", "123");
+        sess.setItem("/test_module:popelnice/s", "foo");
+        sess.applyChanges();
+
+        REQUIRE(queue->pop().changes == std::vector<sysrepo::ChangeRecord>{
+            {sysrepo::ChangeOperation::Created, "/test_module:leafInt32", "123", std::nullopt, std::nullopt, false},
+            {sysrepo::ChangeOperation::Created, "/test_module:popelnice", std::nullopt, std::nullopt, std::nullopt, false},
+            {sysrepo::ChangeOperation::Created, "/test_module:popelnice/s", "foo", std::nullopt, std::nullopt, false},
+        });
+    }
+
+    DOCTEST_SUBCASE("coalesced changes")
+    {
+        std::mutex mtx;
+        std::vector<sysrepo::ChangeSet> received;
+        std::optional<sysrepo::Subscription> sub = sess.onModuleChange("test_module", [] (auto, auto, auto, auto, auto, auto) { return sysrepo::ErrorCode::Ok; });
+        sub->onModuleChangeCoalesced("test_module", [&] (const sysrepo::ChangeSet& changes) {
+            std::lock_guard lock{mtx};
+            received.emplace_back(changes);
+        }, std::chrono::milliseconds{300});
+
+        sess.setItem("/test_module:leafInt32", "1");
+        sess.applyChanges();
+        sess.setItem("/test_module:leafInt32", "2");
+        sess.setItem("/test_module:popelnice/s", "foo");
+        sess.applyChanges();
+        sess.setItem("/test_module:leafInt32", "3");
+        sess.deleteItem("/test_module:popelnice");
+        sess.applyChanges();
+
+        DOCTEST_SUBCASE("window expires")
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{600});
+        }
+
+        DOCTEST_SUBCASE("flushed on unsubscribe")
+        {
+            sub.reset();
+        }
+
+        std::lock_guard lock{mtx};
+        REQUIRE(received.size() == 1);
+        REQUIRE(received.front().changes == std::vector<sysrepo::ChangeRecord>{
+            {sysrepo::ChangeOperation::Created, "/test_module:leafInt32", "3", std::nullopt, std::nullopt, false},
+        });
+    }
+
+    DOCTEST_SUBCASE("shadow tree")
+    {
+        std::vector<std::pair<std::optional<std::string>, std::optional<std::string>>> seen;
+        auto leafValue = [] (const std::optional<libyang::DataNode>& tree) -> std::optional<std::string> {
+            if (!tree) {
+                return std::nullopt;
+            }
+            auto leaf = tree->findPath("/test_module:leafInt32");
+            return leaf ? std::optional<std::string>{leaf->asTerm().valueStr()} : std::nullopt;
+        };
+        auto sub = sess.onModuleChange("test_module", [] (auto, auto, auto, auto, auto, auto) { return sysrepo::ErrorCode::Ok; });
+        sub.onModuleChangeShadowed("test_module", [&] (auto, auto, auto, auto, auto event, auto, const auto& oldTree, const auto& newTree) {
+            if (event == sysrepo::Event::Change) {
+                seen.emplace_back(leafValue(oldTree), leafValue(newTree));
+            }
+            return sysrepo::ErrorCode::Ok;
+        });
+
+        sess.setItem("/test_module:leafInt32", "1");
+        sess.applyChanges();
+        sess.setItem("/test_module:leafInt32", "2");
+        sess.applyChanges();
+        sess.deleteItem("/test_module:leafInt32");
+        sess.applyChanges();
+
+        REQUIRE(seen == decltype(seen){
+            {std::nullopt, "1"},
+            {"1", "2"},
+            {"2", std::nullopt},
+        });
+    }
+
+    DOCTEST_SUBCASE("shadow tree with an XPath filter")
+    {
+        std::vector<std::tuple<std::optional<std::string>, std::optional<std::string>, std::optional<std::string>, std::optional<std::string>>> seen;
+        auto value = [] (const std::optional<libyang::DataNode>& tree, const std::string& path) -> std::optional<std::string> {
+            if (!tree) {
+                return std::nullopt;
+            }
+            auto leaf = tree->findPath(path);
+            return leaf ? std::optional<std::string>{leaf->asTerm().valueStr()} : std::nullopt;
+        };
+        auto sub = sess.onModuleChange("test_module", [] (auto, auto, auto, auto, auto, auto) { return sysrepo::ErrorCode::Ok; });
+        sub.onModuleChangeShadowed("test_module", [&] (auto, auto, auto, auto, auto event, auto, const auto& oldTree, const auto& newTree) {
+            if (event == sysrepo::Event::Change) {
+                seen.emplace_back(
+                        value(oldTree, "/test_module:leafInt32"),
+                        value(newTree, "/test_module:leafInt32"),
+                        value(oldTree, "/test_module:popelnice/s"),
+                        value(newTree, "/test_module:popelnice/s"));
+            }
+            return sysrepo::ErrorCode::Ok;
+        }, "/test_module:leafInt32");
+
+        // outside of the filter, but the shadow tree still has to follow it
+        sess.setItem("/test_module:popelnice/s", "foo");
+        sess.applyChanges();
+        REQUIRE(seen.empty());
+
+        sess.setItem("/test_module:leafInt32", "1");
+        sess.applyChanges();
+        sess.deleteItem("/test_module:popelnice");
+        sess.setItem("/test_module:leafInt32", "2");
+        sess.applyChanges();
+
+        REQUIRE(seen == decltype(seen){
+            {std::nullopt, "1", "foo", "foo"},
+            {"1", "2", "foo", std::nullopt},
+        });
+    }
+
+    DOCTEST_SUBCASE("changes grouped by list instance")
+    {
+        using Keys = std::vector<std::pair<std::string, std::string>>;
+        std::vector<std::tuple<sysrepo::ChangeOperation, Keys, std::vector<std::string>>> seen;
+        auto sub = sess.onModuleChange("test_module", [&seen] (sysrepo::Session session, auto, auto, auto, auto, auto) {
+            for (const auto& instance : sysrepo::groupByListInstance(session.getChanges())) {
+                std::vector<std::string> paths;
+                for (const auto& change : instance.changes) {
+                    paths.emplace_back(change.node.path());
+                }
+                seen.emplace_back(instance.operation, instance.keys, paths);
+            }
+            return sysrepo::ErrorCode::Ok;
+        }, std::nullopt, 0, sysrepo::SubscribeOptions::DoneOnly);
+
+        sess.setItem("/test_module:popelnice/content/trash[name='a']/cont/l", "x");
+        sess.setItem("/test_module:popelnice/content/trash[name='b']", std::nullopt);
+        sess.applyChanges();
+        REQUIRE(seen == decltype(seen){
+            {sysrepo::ChangeOperation::Created, Keys{{"name", "a"}}, {
+                "/test_module:popelnice/content/trash[name='a']/name",
+                "/test_module:popelnice/content/trash[name='a']/cont",
+                "/test_module:popelnice/content/trash[name='a']/cont/l",
+            }},
+            {sysrepo::ChangeOperation::Created, Keys{{"name", "b"}}, {
+                "/test_module:popelnice/content/trash[name='b']/name",
+            }},
+        });
+
+        seen.clear();
+        sess.setItem("/test_module:popelnice/content/trash[name='a']/cont/l", "y");
+        sess.deleteItem("/test_module:popelnice/content/trash[name='b']");
+        sess.applyChanges();
+        REQUIRE(seen == decltype(seen){
+            {sysrepo::ChangeOperation::Modified, Keys{{"name", "a"}}, {
+                "/test_module:popelnice/content/trash[name='a']/cont/l",
+            }},
+            {sysrepo::ChangeOperation::Deleted, Keys{{"name", "b"}}, {
+                "/test_module:popelnice/content/trash[name='b']/name",
+            }},
+        });
+    }
+
+    DOCTEST_SUBCASE("materialized view")
+    {
+        using Trash = std::map<std::string, std::string>;
+        sess.setItem("/test_module:popelnice/content/trash[name='a']/cont/l", "x");
+        sess.applyChanges();
+
+        std::atomic<int> builds = 0;
+        std::atomic<bool> applyThrows = false;
+        std::atomic<int> exceptions = 0;
+        sysrepo::MaterializedView<Trash> view{sess, "test_module", [&builds] (const std::optional<libyang::DataNode>& data) {
+            builds++;
+            Trash res;
+            if (data) {
+                for (const auto& node : data->findXPath("/test_module:popelnice/content/trash/cont/l")) {
+                    res[std::string{node.parent()->parent()->findPath("name")->asTerm().valueStr()}] = node.asTerm().valueStr();
+                }
+            }
+            return res;
+        }, [&applyThrows] (Trash& view, const sysrepo::ChangeCollection& changes) {
+            if (applyThrows) {
+                view.clear();
+                throw std::runtime_error{"apply failed"};
+            }
+            for (const auto& instance : sysrepo::groupByListInstance(changes)) {
+                if (instance.operation == sysrepo::ChangeOperation::Deleted) {
+                    view.erase(instance.keys.front().second);
+                    continue;
+                }
+                for (const auto& change : instance.changes) {
+                    if (change.node.schema().name() == "l") {
+                        view[instance.keys.front().second] = change.node.asTerm().valueStr();
+                    }
+                }
+            }
+        }, std::nullopt, [&exceptions] (std::exception&) { exceptions++; }};
+
+        auto initial = view.snapshot();
+        REQUIRE(*initial == Trash{{"a", "x"}});
+
+        sess.setItem("/test_module:popelnice/content/trash[name='a']/cont/l", "y");
+        sess.setItem("/test_module:popelnice/content/trash[name='b']/cont/l", "z");
+        sess.applyChanges();
+        REQUIRE(*view.snapshot() == Trash{{"a", "y"}, {"b", "z"}});
+
+        sess.deleteItem("/test_module:popelnice/content/trash[name='a']");
+        sess.applyChanges();
+        REQUIRE(*view.snapshot() == Trash{{"b", "z"}});
+        REQUIRE(*initial == Trash{{"a", "x"}});
+        REQUIRE(builds == 1);
+
+        // a failed update is replaced by a rebuild, so that the view does not miss the change
+        applyThrows = true;
+        sess.setItem("/test_module:popelnice/content/trash[name='c']/cont/l", "w");
+        sess.applyChanges();
+        REQUIRE(*view.snapshot() == Trash{{"b", "z"}, {"c", "w"}});
+        REQUIRE(builds == 2);
+        REQUIRE(exceptions == 1);
+    }
+
+    DOCTEST_SUBCASE("parsing the request XPath")
+    {
+        auto ctx = sess.getContext();
+        auto trash = ctx.findPath("/test_module:popelnice/content/trash");
+        auto l = ctx.findPath("/test_module:popelnice/content/trash/cont/l");
+        auto s = ctx.findPath("/test_module:popelnice/s");
+
+        auto req = sysrepo::parseRequestXPath(ctx, "/test_module:popelnice/content/trash[name='b']/cont");
+        REQUIRE(req.exact);
+        REQUIRE(req.steps.size() == 4);
+        REQUIRE(req.steps[2].constraints == std::vector<sysrepo::KeyConstraint>{{"name", sysrepo::KeyConstraint::Operator::Equal, "b"}});
+        REQUIRE(req.isRequested(trash));
+        REQUIRE(req.isRequested(l));
+        REQUIRE(!req.isRequested(s));
+        REQUIRE(req.isRequested(trash, {{"name", "b"}}));
+        REQUIRE(!req.isRequested(trash, {{"name", "a"}}));
+
+        req = sysrepo::parseRequestXPath(ctx, "/test_module:popelnice/content/trash[name >= 'b' and name < 'd']");
+        REQUIRE(req.exact);
+        REQUIRE(!req.isRequested(trash, {{"name", "a"}}));
+        REQUIRE(req.isRequested(trash, {{"name", "c"}}));
+        REQUIRE(!req.isRequested(trash, {{"name", "d"}}));
+
+        // no whitespace is needed around `and` next to a literal, and an `and` within a literal is not an operator
+        req = sysrepo::parseRequestXPath(ctx, "/test_module:popelnice/content/trash[name>='b'and\n\tname<'d']");
+        REQUIRE(req.exact);
+        REQUIRE(req.steps[2].constraints.size() == 2);
+        REQUIRE(req.isRequested(trash, {{"name", "c"}}));
+        REQUIRE(!req.isRequested(trash, {{"name", "d"}}));
+        req = sysrepo::parseRequestXPath(ctx, "/test_module:popelnice/content/trash[name='salt and pepper']");
+        REQUIRE(req.exact);
+        REQUIRE(req.steps[2].constraints == std::vector<sysrepo::KeyConstraint>{{"name", sysrepo::KeyConstraint::Operator::Equal, "salt and pepper"}});
+        req = sysrepo::parseRequestXPath(ctx, "/test_module:popelnice/content/trash[name='a'or name='b']");
+        REQUIRE(!req.exact);
+
+        req = sysrepo::parseRequestXPath(ctx, "/test_module:values[. > 9]");
+        REQUIRE(req.exact);
+        REQUIRE(req.isRequested(ctx.findPath("/test_module:values"), {{".", "10"}}));
+        REQUIRE(!req.isRequested(ctx.findPath("/test_module:values"), {{".", "2"}}));
+
+        // whatever is not understood makes the request broader
+        req = sysrepo::parseRequestXPath(ctx, "/test_module:popelnice/content/trash[cont/l='x']/cont");
+        REQUIRE(!req.exact);
+        REQUIRE(req.steps.size() == 3);
+        REQUIRE(req.steps[2].constraints.empty());
+        REQUIRE(req.isRequested(trash, {{"name", "a"}}));
+        req = sysrepo::parseRequestXPath(ctx, "/test_module:popelnice//l");
+        REQUIRE(!req.exact);
+        REQUIRE(req.steps.size() == 1);
+        REQUIRE(req.isRequested(s));
+        req = sysrepo::parseRequestXPath(ctx, "/test_module:stateLeaf | /test_module:popelnice");
+        REQUIRE(!req.exact);
+        REQUIRE(req.steps.empty());
+        REQUIRE(req.isRequested(s));
+
+        std::optional<sysrepo::RequestedData> seen;
+        auto sub = sess.onOperGet("test_module", [&seen] (auto session, auto, auto, auto, auto requestXPath, auto, auto& parent) {
+            seen = sysrepo::parseRequestXPath(session.getContext(), *requestXPath);
+            parent = session.getContext().newPath("/test_module:stateLeaf", "123");
+            return sysrepo::ErrorCode::Ok;
+        }, "/test_module:stateLeaf");
+        sess.switchDatastore(sysrepo::Datastore::Operational);
+        REQUIRE(sess.getData("/test_module:stateLeaf"));
+        REQUIRE(seen);
+        REQUIRE(seen->exact);
+        REQUIRE(seen->isRequested(ctx.findPath("/test_module:stateLeaf")));
+        REQUIRE(!seen->isRequested(s));
+    }
+
+    DOCTEST_SUBCASE("sharded operational data")
+    {
+        std::atomic<int> running = 0;
+        std::atomic<bool> concurrent = true;
+        auto shard = [&running, &concurrent] (const std::string& name) -> sysrepo::OperGetCb {
+            return [&running, &concurrent, name] (auto session, auto, auto, auto, auto, auto, auto& parent) {
+                running++;
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+                while (running < 2 && std::chrono::steady_clock::now() < deadline) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+                }
+                if (running < 2) {
+                    concurrent = false;
+                }
+                parent = session.getContext().newPath("/test_module:popelnice/content/trash[name='" + name + "']/cont/l", name);
+                return sysrepo::ErrorCode::Ok;
+            };
+        };
+        auto sub = sess.onModuleChange("test_module", [] (auto, auto, auto, auto, auto, auto) { return sysrepo::ErrorCode::Ok; });
+        sub.onOperGetSharded("test_module", {shard("a"), shard("b")}, "/test_module:popelnice");
+        sess.switchDatastore(sysrepo::Datastore::Operational);
+
+        auto data = sess.getData("/test_module:popelnice");
+        REQUIRE(data);
+        REQUIRE(concurrent);
+        REQUIRE(data->findPath("/test_module:popelnice/content/trash[name='a']/cont/l")->asTerm().valueStr() == "a");
+        REQUIRE(data->findPath("/test_module:popelnice/content/trash[name='b']/cont/l")->asTerm().valueStr() == "b");
+
+        REQUIRE_THROWS_AS(sub.onOperGetSharded("test_module", {}, "/test_module:popelnice"), sysrepo::Error);
+    }
+
+    DOCTEST_SUBCASE("output builder")
+    {
+        sysrepo::OutputBuilder builder{sess, "/test_module:popelnice"};
+        auto trash = builder.field("content/trash");
+        auto name = builder.field("content/trash/name");
+        auto l = builder.field("content/trash/cont/l");
+        auto s = builder.field("s");
+        REQUIRE(builder.field("content/trash").index == trash.index);
+        REQUIRE_THROWS_AS(builder.field("content/nonexistent"), sysrepo::Error);
+
+        std::vector<std::string> names{"a", "b", "c"};
+        std::vector<std::string> values{"x", "y", "z"};
+        auto sub = sess.onOperGet("test_module", [&] (auto, auto, auto, auto, auto, auto, auto& parent) {
+            parent = builder.createBase();
+            builder.create(*parent, s, "hello");
+            auto instance = builder.createListInstance(*parent, trash, {"first"});
+            builder.create(instance, l, "0");
+            std::array columns{
+                sysrepo::OutputBuilder::Column{l, values},
+                sysrepo::OutputBuilder::Column{name, names},
+            };
+            builder.createListInstances(*parent, trash, columns);
+            REQUIRE_THROWS_AS(builder.create(*parent, l, "nope"), sysrepo::Error);
+            return sysrepo::ErrorCode::Ok;
+        }, "/test_module:popelnice");
+        sess.switchDatastore(sysrepo::Datastore::Operational);
+
+        auto data = sess.getData("/test_module:popelnice");
+        REQUIRE(data);
+        REQUIRE(data->findPath("/test_module:popelnice/s")->asTerm().valueStr() == "hello");
+        REQUIRE(data->findPath("/test_module:popelnice/content/trash[name='first']/cont/l")->asTerm().valueStr() == "0");
+        REQUIRE(data->findPath("/test_module:popelnice/content/trash[name='a']/cont/l")->asTerm().valueStr() == "x");
+        REQUIRE(data->findPath("/test_module:popelnice/content/trash[name='c']/cont/l")->asTerm().valueStr() == "z");
+    }
+
+    DOCTEST_SUBCASE("subscription group")
+    {
+        auto before = sysrepo::libraryStats();
+        std::atomic<int> calledOther = 0;
+        sysrepo::SubscriptionGroup group{sess};
+        auto first = group.onModuleChange("test_module", [&called] (auto, auto, auto, auto, auto, auto) {
+            called++;
+            return sysrepo::ErrorCode::Ok;
+        }, std::nullopt, 0, sysrepo::SubscribeOptions::DoneOnly);
+        auto second = group.onModuleChange("test_module", [&calledOther] (auto, auto, auto, auto, auto, auto) {
+            calledOther++;
+            return sysrepo::ErrorCode::Ok;
+        }, std::nullopt, 0, sysrepo::SubscribeOptions::DoneOnly);
+        REQUIRE(first.subscriptionId() != second.subscriptionId());
+        REQUIRE(group.stats().size() == 2);
+        REQUIRE(sysrepo::libraryStats().subscriptionsAlive == before.subscriptionsAlive + 1);
+
+        sess.setItem("/test_module:leafInt32", "123");
+        sess.applyChanges();
+        REQUIRE(called == 1);
+        REQUIRE(calledOther == 1);
+
+        DOCTEST_SUBCASE("explicit unsubscribe")
+        {
+            first.unsubscribe();
+        }
+
+        DOCTEST_SUBCASE("handle goes out of scope")
+        {
+            auto dropped = std::move(first);
+        }
+
+        REQUIRE(group.stats().size() == 1);
+        sess.setItem("/test_module:leafInt32", "124");
+        sess.applyChanges();
+        REQUIRE(called == 1);
+        REQUIRE(calledOther == 2);
+        REQUIRE(sysrepo::libraryStats().subscriptionsAlive == before.subscriptionsAlive + 1);
+    }
+
     DOCTEST_SUBCASE("Session's lifetime is prolonged by the subscription")
     {
         auto sub = sysrepo::Connection().sessionStart().onModuleChange("test_module", [] (auto, auto, auto, auto, auto, auto) -> sysrepo::ErrorCode {
@@ -429,6 +1279,47 @@ TEST_CASE("subscriptions")
         }
     }
 
+    DOCTEST_SUBCASE("RPC router")
+    {
+        Recorder rec;
+        sess.setItem("/test_module:popelnice/content/trash[name='c++']", std::nullopt);
+        sess.applyChanges();
+
+        sysrepo::RpcRouter router{sess};
+        router.on("/test_module:noop", [&] (auto, const libyang::DataNode& input, const std::vector<libyang::DataNodeTerm>& parentKeys, auto, auto) {
+            rec.recordRPC(input.path() + " " + std::to_string(parentKeys.size()));
+            return sysrepo::ErrorCode::Ok;
+        });
+        router.on("/test_module:popelnice/content/trash/empty", [&] (auto, const libyang::DataNode& input, const std::vector<libyang::DataNodeTerm>& parentKeys, auto, libyang::DataNode output) {
+            for (const auto& key : parentKeys) {
+                rec.recordRPC(input.path() + " " + std::string{key.valueStr()});
+            }
+            output.newPath("emptied", "true", libyang::CreationOptions::Output);
+            return sysrepo::ErrorCode::Ok;
+        });
+        REQUIRE_THROWS_AS(router.on("/test_module:ping", [] (auto, auto&, auto&, auto, auto) { return sysrepo::ErrorCode::Ok; }), sysrepo::Error);
+        REQUIRE_THROWS_AS(router.on("/test_module:shutdown", nullptr), sysrepo::Error);
+
+        {
+            REQUIRE_CALL(rec, recordRPC("/test_module:noop 0"));
+            sess.sendRPC(sess.getContext().newPath("/test_module:noop"));
+        }
+
+        {
+            REQUIRE_CALL(rec, recordRPC("/test_module:popelnice/content/trash[name='c++']/empty c++"));
+            auto output = sess.sendRPC(sess.getContext().newPath("/test_module:popelnice/content/trash[name='c++']/empty"));
+            REQUIRE(output.findPath("/test_module:popelnice/content/trash[name='c++']/empty/emptied", libyang::InputOutputNodes::Output));
+        }
+
+        // a new handler replaces the old one without subscribing again
+        router.on("/test_module:noop", [&] (auto, auto, auto, auto, auto) {
+            rec.recordRPC("replaced");
+            return sysrepo::ErrorCode::Ok;
+        });
+        REQUIRE_CALL(rec, recordRPC("replaced"));
+        sess.sendRPC(sess.getContext().newPath("/test_module:noop"));
+    }
+
     DOCTEST_SUBCASE("notifications")
     {
         Recorder rec;
@@ -464,6 +1355,332 @@ TEST_CASE("subscriptions")
         sub = std::nullopt;
     }
 
+    DOCTEST_SUBCASE("notification template")
+    {
+        std::mutex mtx;
+        std::vector<std::string> received;
+        auto sub = sess.onNotification("test_module", [&] (auto, auto, auto type, const std::optional<libyang::DataNode> notification, auto) {
+            if (type != sysrepo::NotificationType::Realtime) {
+                return;
+            }
+            std::lock_guard lock{mtx};
+            received.emplace_back(notification->findPath("/test_module:ping/myLeaf")->asTerm().valueStr());
+        }, "/test_module:ping");
+
+        auto notification = sess.getContext().newPath("/test_module:ping");
+        notification.newPath("myLeaf", "0");
+        sysrepo::TreeTemplate tmpl{notification};
+        auto myLeaf = tmpl.slot("/test_module:ping/myLeaf");
+        REQUIRE_THROWS_AS(tmpl.slot("/test_module:ping/nonexistent"), sysrepo::Error);
+
+        for (int32_t i = 1; i <= 3; i++) {
+            tmpl.set(myLeaf, i);
+            sess.sendNotification(tmpl.tree(), sysrepo::Wait::Yes);
+        }
+        tmpl.reset();
+        sess.sendNotification(tmpl.tree(), sysrepo::Wait::Yes);
+        REQUIRE_THROWS_AS(tmpl.set(myLeaf, "not a number"), sysrepo::Error);
+
+        std::lock_guard lock{mtx};
+        REQUIRE(received == std::vector<std::string>{"1", "2", "3", "0"});
+    }
+
+    DOCTEST_SUBCASE("sending notifications in bulk")
+    {
+        std::mutex mtx;
+        std::vector<std::string> received;
+        auto sub = sess.onNotification("test_module", [&] (auto, auto, auto type, const std::optional<libyang::DataNode> notification, auto) {
+            if (type != sysrepo::NotificationType::Realtime) {
+                return;
+            }
+            std::lock_guard lock{mtx};
+            received.emplace_back(notification->path());
+        });
+
+        std::vector<libyang::DataNode> batch;
+        for (int i = 0; i < 3; i++) {
+            batch.emplace_back(sess.getContext().newPath("/test_module:ping"));
+            batch.back().newPath("myLeaf", std::to_string(i));
+        }
+        batch.insert(batch.begin() + 1, sess.getContext().newPath("/test_module:leafInt32", "1"));
+        batch.emplace_back(sess.getContext().newPath("/test_module:silent-ping"));
+
+        auto failures = sess.sendNotifications(batch, sysrepo::Wait::Yes);
+        REQUIRE(failures.size() == 1);
+        REQUIRE(failures.front().index == 1);
+        REQUIRE(failures.front().errorMessage.starts_with("Couldn't send notification: "));
+
+        std::lock_guard lock{mtx};
+        REQUIRE(received == std::vector<std::string>{"/test_module:ping", "/test_module:ping", "/test_module:ping", "/test_module:silent-ping"});
+    }
+
+    DOCTEST_SUBCASE("queued notifications")
+    {
+        auto policy = sysrepo::OverflowPolicy::Block;
+        std::vector<std::string> expected;
+        uint64_t expectedDrops = 0;
+
+        DOCTEST_SUBCASE("drop oldest")
+        {
+            policy = sysrepo::OverflowPolicy::DropOldest;
+            expected = {"2", "3"};
+            expectedDrops = 2;
+        }
+
+        DOCTEST_SUBCASE("drop newest")
+        {
+            policy = sysrepo::OverflowPolicy::DropNewest;
+            expected = {"0", "1"};
+            expectedDrops = 2;
+        }
+
+        auto ring = std::make_shared<sysrepo::NotificationRing>(2, policy);
+        auto sub = sess.onNotification("test_module", [] (auto, auto, auto, auto, auto) {}, "/test_module:silent-ping");
+        sub.onNotificationQueued("test_module", ring, "/test_module:ping");
+        REQUIRE(ring->capacity() == 2);
+        REQUIRE(!ring->tryPop());
+
+        if (policy == sysrepo::OverflowPolicy::Block) {
+            std::atomic<int> consumed = 0;
+            std::thread consumer{[&ring, &consumed] {
+                std::this_thread::sleep_for(std::chrono::milliseconds{100});
+                for (int i = 0; i < 2; i++) {
+                    ring->pop();
+                    consumed++;
+                }
+            }};
+            for (int i = 0; i < 4; i++) {
+                auto notification = sess.getContext().newPath("/test_module:ping");
+                notification.newPath("myLeaf", std::to_string(i));
+                sess.sendNotification(notification, sysrepo::Wait::No);
+            }
+            consumer.join();
+            REQUIRE(consumed == 2);
+            expected = {"2", "3"};
+        } else {
+            for (int i = 0; i < 4; i++) {
+                auto notification = sess.getContext().newPath("/test_module:ping");
+                notification.newPath("myLeaf", std::to_string(i));
+                sess.sendNotification(notification, sysrepo::Wait::Yes);
+            }
+        }
+
+        // Wait::No does not say when the notifications have been queued
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+        std::vector<std::string> received;
+        while (received.size() < expected.size() && std::chrono::steady_clock::now() < deadline) {
+            if (auto notification = ring->tryPop()) {
+                REQUIRE(notification->type == sysrepo::NotificationType::Realtime);
+                received.emplace_back(notification->tree->findPath("/test_module:ping/myLeaf")->asTerm().valueStr());
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            }
+        }
+        REQUIRE(received == expected);
+        REQUIRE(ring->dropped() == expectedDrops);
+        REQUIRE(ring->highWaterMark() == 2);
+    }
+
+    DOCTEST_SUBCASE("notification store")
+    {
+        auto file = std::filesystem::temp_directory_path() / ("sysrepo-cpp-notifications-" + std::to_string(getpid()));
+        std::filesystem::remove(file);
+        auto ping = [&sess] (int value) {
+            auto notification = sess.getContext().newPath("/test_module:ping");
+            notification.newPath("myLeaf", std::to_string(value));
+            return notification;
+        };
+        auto at = [] (int seconds) { return sysrepo::NotificationTimeStamp{std::chrono::seconds{seconds}}; };
+        auto values = [] (const std::vector<sysrepo::StoredNotification>& stored) {
+            std::vector<std::string> res;
+            for (const auto& notification : stored) {
+                res.emplace_back(notification.tree.findPath("/test_module:ping/myLeaf")->asTerm().valueStr());
+            }
+            return res;
+        };
+
+        {
+            sysrepo::NotificationStore store{sess, file};
+            REQUIRE(store.size() == 0);
+            REQUIRE(!store.lastTimestamp());
+            store.append(ping(1), at(10));
+            store.append(ping(3), at(30));
+            // out of order, still ends up in the right place
+            store.append(ping(2), at(20));
+            store.flush();
+
+            auto expected = "NotificationStore: " + file.string() + " is in use";
+            REQUIRE_THROWS_WITH_AS(sysrepo::NotificationStore(sess, file), expected.c_str(), sysrepo::Error);
+        }
+
+        sysrepo::NotificationStore store{sess, file};
+        REQUIRE(store.size() == 3);
+        REQUIRE(store.lastTimestamp() == at(30));
+        REQUIRE(values(store.query()) == std::vector<std::string>{"1", "2", "3"});
+        REQUIRE(values(store.query(at(15), at(30))) == std::vector<std::string>{"2", "3"});
+        REQUIRE(values(store.query(std::nullopt, at(20))) == std::vector<std::string>{"1", "2"});
+        REQUIRE(values(store.query(std::nullopt, std::nullopt, "/test_module:ping[myLeaf='2']")) == std::vector<std::string>{"2"});
+        REQUIRE(store.query(at(31)).empty());
+
+        std::filesystem::remove(file);
+    }
+
+    DOCTEST_SUBCASE("notification store resuming after a restart")
+    {
+        auto file = std::filesystem::temp_directory_path() / ("sysrepo-cpp-notifications-" + std::to_string(getpid()));
+        std::filesystem::remove(file);
+        conn.setModuleReplaySupport("test_module", true);
+        auto ping = [&sess] (int value) {
+            auto notification = sess.getContext().newPath("/test_module:ping");
+            notification.newPath("myLeaf", std::to_string(value));
+            return notification;
+        };
+        auto values = [] (const std::vector<sysrepo::StoredNotification>& stored) {
+            std::vector<std::string> res;
+            for (const auto& notification : stored) {
+                res.emplace_back(notification.tree.findPath("/test_module:ping/myLeaf")->asTerm().valueStr());
+            }
+            return res;
+        };
+
+        {
+            sysrepo::NotificationStore store{sess, file};
+            auto sub = store.subscribe(sess, "test_module", "/test_module:ping");
+            sess.sendNotification(ping(1), sysrepo::Wait::Yes);
+            sess.sendNotification(ping(2), sysrepo::Wait::Yes);
+            REQUIRE(store.size() == 2);
+        }
+
+        // sent while the application is down, sysrepo keeps it for the replay
+        sess.sendNotification(ping(3), sysrepo::Wait::Yes);
+
+        sysrepo::NotificationStore store{sess, file};
+        auto sub = store.subscribe(sess, "test_module", "/test_module:ping");
+        // the replay is delivered asynchronously
+        for (int i = 0; i < 500 && store.size() < 3; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+        REQUIRE(values(store.query()) == std::vector<std::string>{"1", "2", "3"});
+        sess.sendNotification(ping(4), sysrepo::Wait::Yes);
+        // only the missed notification is replayed, the newest stored one is not stored twice
+        REQUIRE(values(store.query()) == std::vector<std::string>{"1", "2", "3", "4"});
+
+        conn.setModuleReplaySupport("test_module", false);
+        std::filesystem::remove(file);
+    }
+
+    DOCTEST_SUBCASE("corrupted notification store")
+    {
+        auto file = std::filesystem::temp_directory_path() / ("sysrepo-cpp-notifications-" + std::to_string(getpid()));
+        {
+            // a header claiming one record, whose length points past the end of the file
+            std::ofstream out{file, std::ios::binary | std::ios::trunc};
+            const uint64_t used = 32;
+            const int64_t timestamp = 0;
+            const uint32_t length = 1000;
+            const uint32_t reserved = 0;
+            out.write("SRNOTIF1", 8);
+            out.write(reinterpret_cast<const char*>(&used), sizeof(used));
+            out.write(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
+            out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+            out.write(reinterpret_cast<const char*>(&reserved), sizeof(reserved));
+            out.write(std::string(16, '\0').data(), 16);
+        }
+
+        auto expected = "NotificationStore: " + file.string() + " is corrupted";
+        REQUIRE_THROWS_WITH_AS(sysrepo::NotificationStore(sess, file), expected.c_str(), sysrepo::Error);
+        std::filesystem::remove(file);
+    }
+
+    DOCTEST_SUBCASE("notification throttling")
+    {
+        std::mutex mtx;
+        std::vector<std::string> received;
+        auto sub = sess.onNotification("test_module", [&] (auto, auto, auto type, const std::optional<libyang::DataNode> notification, auto) {
+            if (type != sysrepo::NotificationType::Realtime) {
+                return;
+            }
+            std::lock_guard lock{mtx};
+            if (auto myLeaf = notification->findPath("/test_module:ping/myLeaf")) {
+                received.emplace_back(myLeaf->asTerm().valueStr());
+            } else {
+                received.emplace_back("silent");
+            }
+        });
+
+        auto ping = [&sess] (int value) {
+            auto notification = sess.getContext().newPath("/test_module:ping");
+            notification.newPath("myLeaf", std::to_string(value));
+            return notification;
+        };
+        sysrepo::NotificationThrottle throttle{sess, {.window = std::chrono::hours{1}, .burst = 2}, [&] (const std::string& path, uint64_t suppressed) {
+            REQUIRE(path == "/test_module:ping");
+            // called without any lock held, so using the throttle does not deadlock
+            REQUIRE(throttle.suppressed() == 3);
+            return ping(1000 + suppressed);
+        }};
+
+        REQUIRE(throttle.send(ping(1), sysrepo::Wait::Yes));
+        REQUIRE(!throttle.send(ping(1), sysrepo::Wait::Yes));
+        REQUIRE(throttle.send(ping(2), sysrepo::Wait::Yes));
+        REQUIRE(!throttle.send(ping(3), sysrepo::Wait::Yes));
+        // a different path has its own window
+        REQUIRE(throttle.send(sess.getContext().newPath("/test_module:silent-ping"), sysrepo::Wait::Yes));
+        REQUIRE(throttle.suppressed() == 2);
+
+        // the window is still open, nothing to summarize yet
+        throttle.flush();
+        REQUIRE(!throttle.send(ping(5), sysrepo::Wait::Yes));
+        REQUIRE(throttle.suppressed() == 3);
+        {
+            std::lock_guard lock{mtx};
+            REQUIRE(received == std::vector<std::string>{"1", "2", "silent"});
+        }
+
+        // ends the window without waiting for it
+        throttle.flush(true);
+        REQUIRE(throttle.send(ping(4), sysrepo::Wait::Yes));
+
+        std::lock_guard lock{mtx};
+        REQUIRE(received == std::vector<std::string>{"1", "2", "silent", "1003", "4"});
+    }
+
+    DOCTEST_SUBCASE("notification router")
+    {
+        std::mutex mtx;
+        std::vector<std::string> received;
+        sysrepo::NotificationRouter router{sess};
+        auto stale = [&] (auto, auto, auto&, auto) {
+            std::lock_guard lock{mtx};
+            received.emplace_back("stale");
+        };
+        // subscribing fails, so the handler must not be kept
+        REQUIRE_THROWS_AS(router.on("/test_module:ping", stale, sysrepo::SubscribeOptions::NoThread), sysrepo::Error);
+        router.on("/test_module:silent-ping", [&] (auto, auto, const libyang::DataNode& notification, auto) {
+            std::lock_guard lock{mtx};
+            received.emplace_back(notification.path());
+        });
+        auto ping = sess.getContext().newPath("/test_module:ping");
+        ping.newPath("myLeaf", "42");
+        sess.sendNotification(ping, sysrepo::Wait::Yes);
+
+        router.on("/test_module:ping", [&] (auto, auto type, const libyang::DataNode& notification, auto) {
+            if (type != sysrepo::NotificationType::Realtime) {
+                return;
+            }
+            std::lock_guard lock{mtx};
+            received.emplace_back(notification.findPath("myLeaf")->asTerm().valueStr());
+        });
+        REQUIRE_THROWS_AS(router.on("/test_module:stateLeaf", [] (auto, auto, auto&, auto) {}), sysrepo::Error);
+        REQUIRE_THROWS_AS(router.on("/test_module:ping", nullptr), sysrepo::Error);
+
+        sess.sendNotification(ping, sysrepo::Wait::Yes);
+        sess.sendNotification(sess.getContext().newPath("/test_module:silent-ping"), sysrepo::Wait::Yes);
+
+        std::lock_guard lock{mtx};
+        REQUIRE(received == std::vector<std::string>{"42", "/test_module:silent-ping"});
+    }
+
     DOCTEST_SUBCASE("Session::setErrorMessage")
     {
         const char* message = nullptr;
@@ -583,6 +1800,59 @@ TEST_CASE("subscriptions")
         sess.applyChanges();
     }
 
+    DOCTEST_SUBCASE("Tracing")
+    {
+        struct RecordedSpan {
+            std::string operation;
+            std::optional<std::string> traceId;
+            std::optional<sysrepo::ErrorCode> result;
+        };
+        std::mutex mtx;
+        std::vector<RecordedSpan> spans;
+
+        sysrepo::setTracer(sysrepo::Tracer{
+            .startSpan = [&] (const sysrepo::SpanInfo& info) -> uint64_t {
+                std::lock_guard lock{mtx};
+                spans.push_back({std::string{info.operation}, info.traceId, std::nullopt});
+                return spans.size() - 1;
+            },
+            .endSpan = [&] (uint64_t id, sysrepo::ErrorCode result) {
+                std::lock_guard lock{mtx};
+                spans.at(id).result = result;
+            },
+        });
+
+        sysrepo::ModuleChangeCb moduleChangeCb = [] (sysrepo::Session session, auto, auto, auto, auto, auto) -> sysrepo::ErrorCode {
+            REQUIRE(session.getTraceId() == "trace-123");
+            REQUIRE(session.getOriginatorData(0) == "something else");
+            return sysrepo::ErrorCode::Ok;
+        };
+        auto sub = sess.onModuleChange("test_module", moduleChangeCb, std::nullopt, 0, sysrepo::SubscribeOptions::DoneOnly);
+
+        sess.setOriginatorName("test");
+        sess.pushOriginatorData("something else");
+        sess.setTraceId("trace-000");
+        sess.setTraceId("trace-123");
+        REQUIRE(sess.getTraceId() == "trace-123");
+        REQUIRE(sess.getOriginatorData(0) == "something else");
+        REQUIRE(sess.getOriginatorData(2) == std::nullopt);
+
+        sess.setItem("/test_module:leafInt32", "123");
+        sess.applyChanges();
+        sysrepo::setTracer(std::nullopt);
+        sess.setItem("/test_module:leafInt32", "456");
+
+        std::lock_guard lock{mtx};
+        REQUIRE(spans.size() == 3);
+        REQUIRE(spans[0].operation == "Session::setItem");
+        REQUIRE(spans[1].operation == "Session::applyChanges");
+        REQUIRE(spans[1].traceId == "trace-123");
+        REQUIRE(spans[1].result == sysrepo::ErrorCode::Ok);
+        REQUIRE(spans[2].operation == "ModuleChangeCb");
+        REQUIRE(spans[2].traceId == "trace-123");
+        REQUIRE(spans[2].result == sysrepo::ErrorCode::Ok);
+    }
+
     DOCTEST_SUBCASE("Custom event loop subscription")
     {
         Recorder rec;